@@ -41,14 +41,62 @@
 
 #include <algorithm>
 #include <array>
+#include <charconv>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ADVENT_HAVE_MMAP 1
+#else
+#define ADVENT_HAVE_MMAP 0
+#endif
+
+#if __has_include(<sys/epoll.h>)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define ADVENT_HAVE_EPOLL 1
+#else
+#define ADVENT_HAVE_EPOLL 0
+#endif
+
 
 
 /*
@@ -65,7 +113,13 @@ namespace micro_test_library {
 
 /*  Define test functions with DEF_TEST_FUNC(function_name).
     Use TEST_EQUAL(value, expected_value) to test expected outcomes.
-    Execute all test functions with RUN_TESTS(). */
+    Execute all test functions with RUN_TESTS(), or with RUN_TESTS_TIMED()
+    to also report how long each took.
+
+    Define benchmark functions with DEF_BENCH_FUNC(function_name).
+    Use BENCHMARK(name, iterations, callable) to time a callable.
+    Execute all benchmark functions with RUN_BENCHMARKS(), or just one with
+    RUN_BENCHMARK(function_name). */
 
 
 // (used in test_equal() when called by test functions in this particular module)
@@ -93,7 +147,11 @@ std::ostream & operator<<(std::ostream & os, const std::vector<T> & vec)
 
 unsigned test_count;      // total number of tests executed
 unsigned fault_count;     // total number of tests that fail
-std::vector<void (*)()> test_routines; // list of all test routines
+struct test_routine {
+    void (*f)();
+    const char * name;
+};
+std::vector<test_routine> test_routines; // list of all test routines
 
 
 // write a message to std::cout if !(value == expected_value)
@@ -116,23 +174,85 @@ void test_equal(const A & value, const B & expected_value,
 
 
 // register a test function; return an arbitrary value
-size_t add_test(void (*f)())
+size_t add_test(void (*f)(), const char * name)
 {
-    test_routines.push_back(f);
+    test_routines.push_back({f, name});
     return test_routines.size();
 }
 
 
-// run all registered tests
-void run_tests()
+// run all registered tests; if timed, report the time each took
+void run_tests(bool timed = false)
 {
-    for (auto & t : test_routines)
-        t();
+    for (auto & t : test_routines) {
+        const auto start = std::chrono::steady_clock::now();
+        t.f();
+        const auto stop = std::chrono::steady_clock::now();
+        if (timed) {
+            const std::chrono::duration<double, std::milli> elapsed = stop - start;
+            std::cout << t.name << ": " << elapsed.count() << " ms\n";
+        }
+    }
+    if (timed)
+        std::cout << test_count << " tests\n";
     if (fault_count)
         std::cout << fault_count << " total failures\n";
 }
 
 
+std::vector<test_routine> bench_routines; // list of all benchmark routines
+volatile unsigned long long bench_sink; // (so the optimiser can't discard benchmarked work)
+
+
+// register a benchmark function; return an arbitrary value
+size_t add_bench(void (*f)(), const char * name)
+{
+    bench_routines.push_back({f, name});
+    return bench_routines.size();
+}
+
+
+// run the registered benchmark with the given name, or all of them if none
+// is given; return the number run
+unsigned run_benchmarks(const std::string & name = {})
+{
+    unsigned count = 0;
+    for (auto & b : bench_routines) {
+        if (name.empty() || name == b.name) {
+            b.f();
+            ++count;
+        }
+    }
+    return count;
+}
+
+
+// return the p'th percentile of the given samples, which are reordered
+double percentile(std::vector<double> & samples, double p)
+{
+    if (samples.empty())
+        return 0.0;
+    const size_t n = std::min(samples.size() - 1, static_cast<size_t>(p / 100.0 * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    return samples[n];
+}
+
+
+// call f() the given number of times and report the mean time per call
+template<typename F>
+void benchmark(const char * name, unsigned iterations, F f)
+{
+    unsigned long long sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned n = 0; n < iterations; ++n)
+        sink += static_cast<unsigned long long>(f());
+    const auto stop = std::chrono::steady_clock::now();
+    bench_sink = bench_sink + sink;
+    const std::chrono::duration<double, std::nano> elapsed = stop - start;
+    std::cout << name << ": " << elapsed.count() / iterations << " ns/call\n";
+}
+
+
 // write a message to std::cout if !(value == expected_value)
 #define TEST_EQUAL(value, expected_value)                   \
 {                                                           \
@@ -146,13 +266,36 @@ void run_tests()
 // with one call to RUN_TESTS(). Each test function must have a unique name.
 #define DEF_TEST_FUNC(test_func)                                         \
 void micro_test_##test_func();                                                        \
-size_t micro_test_extern_##test_func = micro_test_library::add_test(micro_test_##test_func); \
+size_t micro_test_extern_##test_func = micro_test_library::add_test(micro_test_##test_func, #test_func); \
 void micro_test_##test_func()
 
 
 // execute all the DEF_TEST_FUNC defined functions
 #define RUN_TESTS() micro_test_library::run_tests()
 
+// as above, reporting the time taken by each
+#define RUN_TESTS_TIMED() micro_test_library::run_tests(true)
+
+
+// time the given callable, which must return a value convertible to an integer
+#define BENCHMARK(name, iterations, callable) \
+    micro_test_library::benchmark(name, iterations, callable)
+
+
+// Benchmark functions are defined like test functions, but are only run
+// by RUN_BENCHMARKS(). Each benchmark function must have a unique name.
+#define DEF_BENCH_FUNC(bench_func)                                         \
+void micro_bench_##bench_func();                                                        \
+size_t micro_bench_extern_##bench_func = micro_test_library::add_bench(micro_bench_##bench_func, #bench_func); \
+void micro_bench_##bench_func()
+
+
+// execute all the DEF_BENCH_FUNC defined functions
+#define RUN_BENCHMARKS() micro_test_library::run_benchmarks()
+
+// execute the DEF_BENCH_FUNC defined function of the given name; return 0 if none
+#define RUN_BENCHMARK(name) micro_test_library::run_benchmarks(name)
+
 } //namespace micro_test_library
 
 
@@ -200,7 +343,7 @@ constexpr uint_least64_t a5_space = 0201004020100ULL;
 
 // Return given string in PDP-10 FORTRAN IV 36-bit integer format.
 // String must contain between 0 and 5 ASCII characters.
-uint_least64_t as_a5(const std::string & str)
+constexpr uint_least64_t as_a5(std::string_view str)
 {
     // Crowther wrote Adventure in FORTRAN IV for a DEC PDP-10. That machine
     // has 36-bit words. FORTRAN packs five 7-bit characters into one 36-bit
@@ -226,6 +369,15 @@ uint_least64_t as_a5(const std::string & str)
     return result;
 }
 
+// Return the given string literal in A5 format, as as_a5(), at compile time.
+// e.g. "WEST"_a5 == as_a5("WEST")
+inline namespace a5_literals {
+consteval uint_least64_t operator""_a5(const char * str, size_t len)
+{
+    return as_a5(std::string_view(str, len));
+}
+}
+
 DEF_TEST_FUNC(as_a5)
 {
     TEST_EQUAL(as_a5(""),       0201004020100ULL); // (= a5_space)
@@ -239,6 +391,11 @@ DEF_TEST_FUNC(as_a5)
     TEST_EQUAL(as_a5("   DE"),  0201004042212ULL);
     TEST_EQUAL(as_a5("    E"),  0201004020212ULL);
     TEST_EQUAL(as_a5("     "),  0201004020100ULL);
+
+    static_assert(as_a5("ABCDE") == 0406050342212ULL);
+    static_assert("WEST"_a5 == as_a5("WEST"));
+    static_assert(""_a5 == a5_space);
+    TEST_EQUAL("XYZZY"_a5, as_a5(std::string("XYZZY")));
 }
 
 
@@ -292,6 +449,370 @@ DEF_TEST_FUNC(as_string)
 }
 
 
+// Up to 20 A5 format words, as packed by pack_a5(). (Unused words are spaces.)
+struct a5_words {
+    std::array<uint_least64_t, 20> word;
+    unsigned size;
+};
+
+// Up to 100 characters, as unpacked by unpack_a5().
+struct a5_chars {
+    std::array<char, 100> chars;
+    unsigned size;
+
+    std::string_view view() const { return std::string_view(chars.data(), size); }
+};
+
+
+namespace a5_swar {
+// (The 8 bytes of a uint_least64_t are called lanes 0..7, lane 0 being the
+// least significant. A5 characters are held in lanes 4..0, first to last.)
+
+constexpr uint_least64_t lanes(uint_least64_t byte) { return byte * 0x0101010101ULL; }
+
+// return up to five chars from p, first in lane 4; lanes past n hold spaces
+inline uint_least64_t load5(const char * p, size_t n)
+{
+    auto lane = [p](int i) { return static_cast<uint_least64_t>(static_cast<unsigned char>(p[i])); };
+    if (n == 5)
+        return lane(0) << 32 | lane(1) << 24 | lane(2) << 16 | lane(3) << 8 | lane(4);
+    uint_least64_t v = lanes(' ');
+    for (size_t i = 0; i < n; ++i)
+        v ^= static_cast<uint_least64_t>((static_cast<unsigned char>(p[i]) ^ ' ')) << ((4 - i) * 8);
+    return v;
+}
+
+// return v with any lane holding 'a'..'z' changed to 'A'..'Z', as std::toupper()
+inline uint_least64_t to_upper5(uint_least64_t v)
+{
+    const uint_least64_t low7 = v & lanes(0x7F);
+    const uint_least64_t ge_a = low7 + lanes(0x80 - 'a');      // (top bit set if >= 'a')
+    const uint_least64_t gt_z = low7 + lanes(0x80 - 'z' - 1);  // (top bit set if > 'z')
+    const uint_least64_t lower = ge_a & ~gt_z & ~v & lanes(0x80);
+    return v ^ (lower >> 2);
+}
+
+// return the five 7-bit characters in lanes 4..0 packed into A5 format
+inline uint_least64_t pack5(uint_least64_t v)
+{
+    v &= lanes(0x7F);
+    v = (v & 0x7F) | ((v >> 1) & (0x7FULL << 7)) | ((v >> 2) & (0x7FULL << 14))
+        | ((v >> 3) & (0x7FULL << 21)) | ((v >> 4) & (0x7FULL << 28));
+    return v << 1;
+}
+
+// return the five 7-bit characters of the given A5 word in lanes 4..0
+inline uint_least64_t unpack5(uint_least64_t a)
+{
+    a >>= 1;
+    return (a & 0x7F) | ((a & (0x7FULL << 7)) << 1) | ((a & (0x7FULL << 14)) << 2)
+        | ((a & (0x7FULL << 21)) << 3) | ((a & (0x7FULL << 28)) << 4);
+}
+
+}// namespace a5_swar
+
+
+// Return the given string packed five characters to a word, as as_a5() packs
+// each five character piece of it; if upper, first uppercased, as as_a5vec()
+// does. Characters after the first 100 are ignored.
+a5_words pack_a5(std::string_view s, bool upper = false)
+{
+    a5_words result;
+    result.size = static_cast<unsigned>(std::min<size_t>(result.word.size(), (s.size() + 4) / 5));
+    for (unsigned w = 0; w < result.size; ++w) {
+        const size_t first = static_cast<size_t>(w) * 5;
+        uint_least64_t v = a5_swar::load5(s.data() + first, std::min<size_t>(5, s.size() - first));
+        if (upper)
+            v = a5_swar::to_upper5(v);
+        result.word[w] = a5_swar::pack5(v);
+    }
+    for (unsigned w = result.size; w < result.word.size(); ++w)
+        result.word[w] = a5_space;
+    return result;
+}
+
+
+// Return the characters of the given A5 words, as as_string() returns them.
+// Words after the first 20 are ignored.
+a5_chars unpack_a5(const uint_least64_t * words, size_t count)
+{
+    a5_chars result;
+    count = std::min<size_t>(count, 20);
+    result.size = static_cast<unsigned>(count * 5);
+    for (size_t w = 0; w < count; ++w) {
+        const uint_least64_t v = a5_swar::unpack5(words[w]);
+        for (int i = 0; i < 5; ++i)
+            result.chars[w * 5 + i] = static_cast<char>(v >> ((4 - i) * 8));
+    }
+    return result;
+}
+
+DEF_TEST_FUNC(pack_a5)
+{
+    // must be bit-identical to the one word at a time functions
+    const std::vector<std::string> strings = {
+        "", "a", "ABCDE", "hello, world", "Supercalifragilisticexpialidocious",
+        "  go  west  ", "{|}~\x7F`@[\\]^_", std::string("nul\0in\x80\xE1\xFF\xFAmiddle", 16),
+        std::string(100, 'z'), std::string(120, 'q')
+    };
+    for (const auto & str : strings) {
+        auto expected = as_a5vec(str);
+        if (expected.size() > 20)
+            expected.resize(20);
+        const a5_words upper = pack_a5(str, true);
+        TEST_EQUAL(std::vector<uint_least64_t>(upper.word.begin(), upper.word.begin() + upper.size), expected);
+        for (unsigned w = upper.size; w < 20; ++w)
+            TEST_EQUAL(upper.word[w], a5_space);
+
+        const a5_words asis = pack_a5(str);
+        for (unsigned w = 0; w < asis.size; ++w)
+            TEST_EQUAL(asis.word[w], as_a5(str.substr(w * 5, 5)));
+
+        std::string chars;
+        for (unsigned w = 0; w < asis.size; ++w)
+            chars += as_string(asis.word[w]);
+        TEST_EQUAL(std::string(unpack_a5(asis.word.data(), asis.size).view()), chars);
+    }
+
+    // every character must survive the round trip as its low 7 bits
+    for (int c = 0; c < 256; ++c) {
+        const std::string str(5, static_cast<char>(c));
+        TEST_EQUAL(pack_a5(str).word[0], as_a5(str));
+        TEST_EQUAL(pack_a5(str, true).word[0], as_a5vec(str)[0]);
+        const a5_words w = pack_a5(str);
+        TEST_EQUAL(std::string(unpack_a5(w.word.data(), 1).view()), as_string(as_a5(str)));
+    }
+}
+
+DEF_BENCH_FUNC(pack_a5)
+{
+    const std::string line{"THE STREAM FLOWS OUT THROUGH A PAIR OF 1 FOOT DIAMETER SEWER PIPES."};
+    BENCHMARK("as_a5vec", 1000000, [&] { return as_a5vec(line)[3]; });
+    BENCHMARK("pack_a5", 1000000, [&] { return pack_a5(line, true).word[3]; });
+    const a5_words words = pack_a5(line);
+    BENCHMARK("as_string", 1000000, [&] {
+        std::string text;
+        for (unsigned w = 0; w < words.size; ++w)
+            text += as_string(words.word[w]);
+        return text.size();
+    });
+    BENCHMARK("unpack_a5", 1000000, [&] { return unpack_a5(words.word.data(), words.size).chars[13]; });
+}
+
+
+// A pseudo-random number generator (xoshiro256**, seeded with splitmix64).
+// [Each game has its own, so games don't share state and a game may be
+// replayed exactly from its seed and its input.]
+class prng {
+public:
+    explicit prng(uint_least64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint_least64_t seed)
+    {
+        for (auto & s : state_) {
+            // splitmix64
+            uint_least64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    // return the next 64 pseudo-random bits
+    uint_least64_t next()
+    {
+        auto rotl = [](uint_least64_t x, int k) { return (x << k) | (x >> (64 - k)); };
+        const uint_least64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint_least64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    // return a pseudo-random number in the range [0.0, 1.0)
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    const std::array<uint_least64_t, 4> & state() const { return state_; }
+    void set_state(const std::array<uint_least64_t, 4> & state) { state_ = state; }
+
+    bool operator==(const prng &) const = default;
+
+private:
+    std::array<uint_least64_t, 4> state_{};
+};
+
+DEF_TEST_FUNC(prng)
+{
+    // (splitmix64 from seed 0 gives e220a8397b1dcdaf, 6e789e6aa1b965f4, ...)
+    prng g(0);
+    TEST_EQUAL(g.state()[0], 0xE220A8397B1DCDAFULL);
+    TEST_EQUAL(g.state()[1], 0x6E789E6AA1B965F4ULL);
+    TEST_EQUAL(g.next(), 0x99EC5F36CB75F2B4ULL);
+
+    // the same seed must give the same sequence; a different seed a different one
+    prng a(42), b(42), c(43);
+    bool same = true, different = false;
+    for (int i = 0; i < 1000; ++i) {
+        const double x = a.uniform();
+        same = same && x == b.uniform();
+        different = different || x != c.uniform();
+        TEST_EQUAL(x >= 0.0 && x < 1.0, true);
+    }
+    TEST_EQUAL(same, true);
+    TEST_EQUAL(different, true);
+
+    // the generator must carry on from a saved state
+    prng d(7);
+    d.next();
+    prng e;
+    e.set_state(d.state());
+    TEST_EQUAL(e == d, true);
+    TEST_EQUAL(e.next(), d.next());
+}
+
+
+// [Not part of Crowther's code. Counts and times the phases of a game, for
+//  an advent_io that returns one from instruments(). The game marks where
+//  each phase begins; a phase lasts until the next begins or the game waits
+//  for input. Calls of speak() are timed on their own, whatever phase they
+//  are made in. Each occurrence of a phase is added to its histogram.]
+class instrumentation {
+public:
+    enum phase : unsigned {
+        other,          // [everything not below]
+        vocabulary,     // [looking up a word, from label 2023]
+        travel,         // [finding where a motion leads, from label 8]
+        dwarves,        // [moving the dwarves, labels 74..69]
+        description,    // [describing the location and its objects, from label 71]
+        speak,          // [each call of speak()]
+        phases
+    };
+    static constexpr std::array<const char *, phases> phase_names = {
+        "other", "vocabulary", "travel", "dwarves", "description", "speak"
+    };
+
+    // upper bounds of the histogram buckets in nanoseconds; the last bucket has none
+    static constexpr std::array<uint_least64_t, 10> bucket_bounds = {
+        100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+    };
+
+    struct histogram {
+        std::array<uint_least64_t, bucket_bounds.size() + 1> buckets{};
+        uint_least64_t count = 0;
+        uint_least64_t sum_ns = 0;
+
+        void add(uint_least64_t ns)
+        {
+            size_t b = 0;
+            while (b < bucket_bounds.size() && ns > bucket_bounds[b])
+                ++b;
+            ++buckets[b];
+            ++count;
+            sum_ns += ns;
+        }
+
+        histogram & operator+=(const histogram & other)
+        {
+            for (size_t b = 0; b < buckets.size(); ++b)
+                buckets[b] += other.buckets[b];
+            count += other.count;
+            sum_ns += other.sum_ns;
+            return *this;
+        }
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    std::array<histogram, phases> phase_time;
+    uint_least64_t ran_calls = 0;
+    uint_least64_t bytes_typed = 0;
+
+    // end the current phase, if any, and begin the given one
+    void enter(phase p)
+    {
+        const auto now = clock::now();
+        if (timing_)
+            phase_time[current_].add(nanoseconds(now - since_));
+        current_ = p;
+        since_ = now;
+        timing_ = true;
+    }
+
+    // end the current phase; nothing is timed until the next enter()
+    void stop()
+    {
+        if (timing_)
+            phase_time[current_].add(nanoseconds(clock::now() - since_));
+        timing_ = false;
+    }
+
+    // add an occurrence of the given phase that began at the given time
+    void record(phase p, clock::time_point since)
+    {
+        phase_time[p].add(nanoseconds(clock::now() - since));
+    }
+
+    // add the counts of another game to these
+    instrumentation & operator+=(const instrumentation & other)
+    {
+        for (size_t p = 0; p < phases; ++p)
+            phase_time[p] += other.phase_time[p];
+        ran_calls += other.ran_calls;
+        bytes_typed += other.bytes_typed;
+        return *this;
+    }
+
+    // return the counts in the Prometheus text exposition format
+    std::string prometheus_text() const
+    {
+        std::ostringstream os;
+        os << "# HELP advent_phase_seconds Time spent in each phase of the game.\n"
+              "# TYPE advent_phase_seconds histogram\n";
+        for (size_t p = 0; p < phases; ++p) {
+            const histogram & h = phase_time[p];
+            uint_least64_t cumulative = 0;
+            for (size_t b = 0; b < h.buckets.size(); ++b) {
+                cumulative += h.buckets[b];
+                os << "advent_phase_seconds_bucket{phase=\"" << phase_names[p] << "\",le=\"";
+                if (b < bucket_bounds.size())
+                    os << bucket_bounds[b] * 1e-9;
+                else
+                    os << "+Inf";
+                os << "\"} " << cumulative << '\n';
+            }
+            os << "advent_phase_seconds_sum{phase=\"" << phase_names[p] << "\"} " << h.sum_ns * 1e-9 << '\n'
+               << "advent_phase_seconds_count{phase=\"" << phase_names[p] << "\"} " << h.count << '\n';
+        }
+        os << "# HELP advent_ran_calls_total Random numbers asked for by the game.\n"
+              "# TYPE advent_ran_calls_total counter\n"
+              "advent_ran_calls_total " << ran_calls << '\n'
+           << "# HELP advent_typed_bytes_total Bytes of output typed by the game.\n"
+              "# TYPE advent_typed_bytes_total counter\n"
+              "advent_typed_bytes_total " << bytes_typed << '\n';
+        return os.str();
+    }
+
+private:
+    static uint_least64_t nanoseconds(clock::duration d)
+    {
+        return static_cast<uint_least64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+    bool timing_ = false;
+    phase current_ = other;
+    clock::time_point since_{};
+};
+
+
+// [Not part of Crowther's code. The labels of Crowther's code, 1..9999, a game
+//  has passed, for an advent_io that returns one from labels_reached().]
+using label_set = std::bitset<10000>;
+
+
 // The adventure function will communicate with the world, including
 // the world of random numbers, through this interface.
 class advent_io {
@@ -305,6 +826,10 @@ public:
     // output an ASCII string
     virtual void type(const std::string &) = 0;
 
+    // output an ASCII string (override this to avoid the copy to std::string)
+    virtual void type(std::string_view msg) { type(std::string(msg)); }
+    void type(const char * msg) { type(std::string_view(msg)); }
+
     // output an integer
     virtual void type(int) = 0;
 
@@ -312,12 +837,21 @@ public:
     virtual void trace_location(int) {}
 
     // return a pseudo-random number between 0.0 and 1.0
-    // (the int perameter is used only to trace the call location for testing)
-    virtual double ran(int)
+    // (the int perameter is used only to trace the call location for testing;
+    // the default is to take the next number from the game's own generator)
+    virtual double ran(int, prng & game_prng)
     {
         // I don't know what PRNG was used in Crowther's FORTRAN 4.
-        return static_cast<double>(std::rand()) / RAND_MAX;
+        return game_prng.uniform();
     }
+
+    // return the counters the game is to update, or nullptr (the default) if
+    // it's not to be instrumented; see advent_io_instrumented
+    virtual instrumentation * instruments() { return nullptr; }
+
+    // return the set to add each label the game passes to, or nullptr (the
+    // default) if the labels aren't to be recorded
+    virtual label_set * labels_reached() { return nullptr; }
 };
 
 std::string advent_io::getline() { return {}; }
@@ -325,6 +859,26 @@ void advent_io::type(const std::string &) {}
 void advent_io::type(int) {}
 
 
+// An advent_io that appends all output to the given string. (For use where
+// input is supplied by other means, so getline() is never expected to be called.)
+class advent_io_string : public advent_io {
+public:
+    explicit advent_io_string(std::string & output) : output_(output) {}
+
+    std::string getline() override
+    {
+        throw adventure_exception("advent_io_string: no input");
+    }
+
+    void type(const std::string & msg) override { output_ += msg; }
+    void type(std::string_view msg) override { output_ += msg; }
+    void type(int n) override { output_ += std::to_string(n); }
+
+private:
+    std::string & output_;
+};
+
+
 // Output a string supplied in FORTRAN 4 (5 chars per 36-bit word) format.
 void type_20a5(
     advent_io & io,
@@ -340,6 +894,46 @@ void type_20a5(
 }
 
 
+// The PAUSE statement in two halves, for callers that cannot wait for input:
+// pause_begin() displays the PAUSE text and pause_end() acts on the user's
+// reply, returning true if execution is to be resumed. See pause() below.
+void pause_begin(advent_io & io, const char * msg)
+{
+    io.type("PAUSE: ");
+    io.type(msg);
+    io.type("\n");
+    io.type("TO RESUME EXECUTION, TYPE: G\n"
+            "TO TERMINATE THE PROGRAM, TYPE: X\n");
+}
+
+// What the user's reply to a PAUSE asks for.
+enum class pause_reply { resume, terminate, repeat };
+
+// Act on the user's reply to a PAUSE without throwing; the caller must end
+// the program if pause_reply::terminate is returned.
+pause_reply pause_answer(advent_io & io, const std::string & reply)
+{
+    const auto input{to_upper(reply)};
+    if (input == "G") {
+        io.type("EXECUTION RESUMED\n\n");
+        return pause_reply::resume;
+    }
+    if (input == "X")
+        return pause_reply::terminate;
+    io.type("TO RESUME EXECUTION, TYPE: G\n"
+            "TO TERMINATE THE PROGRAM, TYPE: X\n");
+    return pause_reply::repeat;
+}
+
+bool pause_end(advent_io & io, const std::string & reply)
+{
+    const pause_reply answer = pause_answer(io, reply);
+    if (answer == pause_reply::terminate)
+        throw adventure_pause_exception();
+    return answer == pause_reply::resume;
+}
+
+
 // Display the PAUSE text and wait for the user to type g or x.
 void pause(advent_io & io, const char * msg)
 {
@@ -363,34 +957,189 @@ void pause(advent_io & io, const char * msg)
 
         I've combined these two into the following:
     */
-    io.type("PAUSE: ");
-    io.type(msg);
-    io.type("\n");
+    pause_begin(io, msg);
+    while (!pause_end(io, io.getline()))
+        ;
+};
 
-    for (;;) {
-        io.type("TO RESUME EXECUTION, TYPE: G\n"
-                "TO TERMINATE THE PROGRAM, TYPE: X\n");
-        const auto input{to_upper(io.getline())};
-        if (input == "G") {
-            io.type("EXECUTION RESUMED\n\n");
-            break;
+
+// An advent_io that collects the output typed between two requests for input
+// and passes it to the given io in one piece when input is next requested, or
+// when flush() is called. Everything else is passed straight through.
+class advent_io_buffered : public advent_io {
+public:
+    using advent_io::type;
+
+    explicit advent_io_buffered(advent_io & io) : io_(io) {}
+    ~advent_io_buffered() override
+    {
+        try { flush(); } catch (...) {}
+    }
+
+    // pass any collected output to the underlying io as one string
+    void flush()
+    {
+        if (!buffer_.empty()) {
+            io_.type(std::string_view(buffer_));
+            buffer_.clear(); // (keeps its capacity, so is reused without allocation)
+        }
+    }
+
+    std::string getline() override
+    {
+        flush();
+        return io_.getline();
+    }
+
+    void type(const std::string & msg) override { buffer_ += msg; }
+    void type(std::string_view msg) override { buffer_ += msg; }
+    void type(int n) override
+    {
+        char buf[16];
+        const int len = std::snprintf(buf, sizeof(buf), "%d", n);
+        buffer_.append(buf, len);
+    }
+    void trace_location(int loc) override { io_.trace_location(loc); }
+    double ran(int n, prng & game_prng) override { return io_.ran(n, game_prng); }
+    instrumentation * instruments() override { return io_.instruments(); }
+    label_set * labels_reached() override { return io_.labels_reached(); }
+
+private:
+    advent_io & io_;
+    std::string buffer_;
+};
+
+
+// An advent_io that passes everything through to the given io, counting the
+// bytes typed and the random numbers asked for, and giving the game the
+// given counters to time its phases with. [Not part of Crowther's code.]
+class advent_io_instrumented : public advent_io {
+public:
+    using advent_io::type;
+
+    advent_io_instrumented(advent_io & io, instrumentation & counters) : io_(io), counters_(counters) {}
+
+    std::string getline() override { return io_.getline(); }
+    void type(const std::string & msg) override { counters_.bytes_typed += msg.size(); io_.type(msg); }
+    void type(std::string_view msg) override { counters_.bytes_typed += msg.size(); io_.type(msg); }
+    void type(int n) override
+    {
+        counters_.bytes_typed += std::to_string(n).size();
+        io_.type(n);
+    }
+    void trace_location(int loc) override { io_.trace_location(loc); }
+    double ran(int n, prng & game_prng) override
+    {
+        ++counters_.ran_calls;
+        return io_.ran(n, game_prng);
+    }
+    instrumentation * instruments() override { return &counters_; }
+    label_set * labels_reached() override { return io_.labels_reached(); }
+
+private:
+    advent_io & io_;
+    instrumentation & counters_;
+};
+
+DEF_TEST_FUNC(advent_io_buffered)
+{
+    // count the writes made to an io that supplies the given replies
+    class advent_io_writes : public advent_io {
+    public:
+        std::string getline() override { return replies.at(index++); }
+        void type(const std::string & msg) override { output += msg; ++writes; }
+        void type(std::string_view msg) override { output += msg; ++writes; }
+        void type(int n) override { output += std::to_string(n); ++writes; }
+
+        std::vector<std::string> replies{"z", "g"};
+        size_t index = 0;
+        std::string output;
+        int writes = 0;
+    };
+
+    advent_io_writes unbuffered;
+    pause(unbuffered, "ERROR 1");
+
+    advent_io_writes target;
+    {
+        advent_io_buffered buffered(target);
+        pause(buffered, "ERROR 1");
+        TEST_EQUAL(target.writes, 2); // (once before each of the two replies)
+        buffered.type("IT'S ");
+        buffered.type(42);
+        buffered.flush();
+        TEST_EQUAL(target.writes, 3);
+        buffered.flush(); // (nothing to write)
+        TEST_EQUAL(target.writes, 3);
+        buffered.type("\n"); // (written when buffered goes out of scope)
+    }
+    TEST_EQUAL(unbuffered.writes > target.writes, true);
+    TEST_EQUAL(target.output, unbuffered.output + "IT'S 42\n");
+    TEST_EQUAL(target.writes, 4);
+}
+
+
+// An advent_io for front ends that cannot wait for input, such as an event
+// loop: a coroutine co_awaits next_line(), and is resumed when the front end
+// supplies a line with supply(). getline() is not used.
+class advent_io_async : public advent_io {
+public:
+    // the awaitable returned by next_line()
+    class line_awaitable {
+    public:
+        explicit line_awaitable(advent_io_async & io) : io_(io) {}
+        bool await_ready() const noexcept { return !io_.lines_.empty(); }
+        void await_suspend(std::coroutine_handle<> h) noexcept { io_.waiting_ = h; }
+        std::string await_resume()
+        {
+            std::string line = std::move(io_.lines_.front());
+            io_.lines_.pop_front();
+            return line;
         }
-        if (input == "X")
-            throw adventure_pause_exception();
+    private:
+        advent_io_async & io_;
+    };
+
+    line_awaitable next_line() { return line_awaitable(*this); }
+
+    // give the game its next line of input; if a coroutine is waiting for
+    // it, it runs until it next waits for input (or ends)
+    void supply(std::string line)
+    {
+        lines_.push_back(std::move(line));
+        if (waiting_) {
+            auto h = waiting_;
+            waiting_ = nullptr;
+            h.resume();
+        }
+    }
+
+    // true if a coroutine is suspended waiting for input
+    bool waiting() const { return static_cast<bool>(waiting_); }
+
+    std::string getline() override
+    {
+        throw adventure_exception("advent_io_async: use next_line()");
     }
+
+private:
+    std::deque<std::string> lines_;
+    std::coroutine_handle<> waiting_;
 };
 
 
 // "The ACCEPT statement reads from standard input." -- FORTRAN IV
 // In Adventure, ACCEPT is used in only one place with a format specifier
-// of "4A5", i.e. 4 ints each holding 5 characters.
-void accept_4A5(advent_io & io, std::array<uint_least64_t, 6> & a)
+// of "4A5", i.e. 4 ints each holding 5 characters. (Here the caller reads
+// the input and passes it in, so that a game may wait for input without
+// blocking; see Crowther::session.)
+void accept_4A5(std::string_view input, std::array<uint_least64_t, 6> & a)
 {
-    std::vector<uint_least64_t> line(as_a5vec(io.getline()));
+    const a5_words line(pack_a5(input.substr(0, 20), true)); // (space filled)
 
     a[0] = 9999; // (a[0] is unused)
     for (unsigned i = 0;  i < 4; ++i)
-        a[i + 1] = (i < line.size()) ? line[i] : a5_space;
+        a[i + 1] = line.word[i];
 
     // There is one place in the original code where ACCEPT is called:
     //      6       ACCEPT 1,(A(I), I=1,4)
@@ -401,34 +1150,201 @@ void accept_4A5(advent_io & io, std::array<uint_least64_t, 6> & a)
     a[5] = a5_space;
 };
 
-}// namespace scaffolding
 
+// Read an integer from the front of the given text, skipping leading white
+// space, as operator>> would; remove what was read and return true if an
+// integer was found. [Not part of Crowther's code.]
+bool read_int(std::string_view & text, int & n)
+{
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+        ++i;
+    if (i + 1 < text.size() && text[i] == '+' && std::isdigit(static_cast<unsigned char>(text[i + 1])))
+        ++i;
+    const char * const end = text.data() + text.size();
+    const auto [p, ec] = std::from_chars(text.data() + i, end, n);
+    if (ec != std::errc())
+        return false;
+    text.remove_prefix(static_cast<size_t>(p - text.data()));
+    return true;
+}
 
+// An input stream over text that is already in memory, for loading the
+// Adventure data file without copying it. [Not part of Crowther's code.]
+// It does only what the loader needs: read integers with operator>>, and the
+// rest of the current line with getline(), which returns a view of the text.
+class text_view_stream {
+public:
+    explicit text_view_stream(std::string_view text) : text_(text) {}
 
+    text_view_stream & operator>>(int & n)
+    {
+        if (!read_int(text_, n))
+            failed_ = true;
+        return *this;
+    }
 
+    explicit operator bool() const { return !failed_; }
 
-/*
-     ######  ########   #######  ##      ## ######## ##     ## ######## ########  
-    ##    ## ##     ## ##     ## ##  ##  ##    ##    ##     ## ##       ##     ## 
-    ##       ##     ## ##     ## ##  ##  ##    ##    ##     ## ##       ##     ## 
-    ##       ########  ##     ## ##  ##  ##    ##    ######### ######   ########  
-    ##       ##   ##   ##     ## ##  ##  ##    ##    ##     ## ##       ##   ##   
-    ##    ## ##    ##  ##     ## ##  ##  ##    ##    ##     ## ##       ##    ##  
-     ######  ##     ##  #######   ###  ###     ##    ##     ## ######## ##     ## 
-*/
+    // return the rest of the current line, without its "\n" or "\r\n"
+    std::string_view getline()
+    {
+        const size_t end = text_.find('\n');
+        std::string_view line = text_.substr(0, end);
+        text_.remove_prefix(end == std::string_view::npos ? text_.size() : end + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
 
-namespace Crowther {
+private:
+    std::string_view text_;
+    bool failed_ = false;
+};
 
-// Original Adventure subroutines
-// (These appear after the Adventure END statement in the original code.)
+// Return the rest of the current line of the given stream; buf holds the
+// line if the stream can't give a view of it. [Not part of Crowther's code.]
+std::string_view rest_of_line(std::istream & is, std::string & buf)
+{
+    std::getline(is, buf);
+    return buf;
+}
 
-                                                    //         SUBROUTINE SHIFT (VAL,DIST,RES)
-void shift(uint_least64_t val, int dist, uint_least64_t & res)
+std::string_view rest_of_line(text_view_stream & is, std::string &)
 {
-                                                    //         IMPLICIT INTEGER (A-Z)
-                                                    //         RES=VAL
-                                                    //         IF(DIST)10,20,30
-                                                    // 10      IDIST=-DIST
+    return is.getline();
+}
+
+
+// The contents of a file, read-only. [Not part of Crowther's code. Where the
+// system has mmap() the file is mapped into memory, so it is read straight
+// from the page cache, which every process reading the file shares; else it
+// is read into memory in one go.]
+class mapped_file {
+public:
+    explicit mapped_file(const std::string & path)
+    {
+#if ADVENT_HAVE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw adventure_exception("mapped_file: cannot open file");
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw adventure_exception("mapped_file: cannot stat file");
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void * p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw adventure_exception("mapped_file: cannot map file");
+            }
+            data_ = static_cast<const char *>(p);
+        }
+        ::close(fd); // (the mapping holds its own reference to the file)
+#else
+        std::ifstream is(path, std::ios::binary);
+        if (!is)
+            throw adventure_exception("mapped_file: cannot open file");
+        copy_.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+        data_ = copy_.data();
+        size_ = copy_.size();
+#endif
+    }
+
+    ~mapped_file()
+    {
+#if ADVENT_HAVE_MMAP
+        if (data_)
+            ::munmap(const_cast<char *>(data_), size_);
+#endif
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+
+    std::string_view text() const { return {data_, size_}; }
+
+private:
+    const char * data_ = nullptr;
+    size_t size_ = 0;
+#if !ADVENT_HAVE_MMAP
+    std::string copy_;
+#endif
+};
+
+
+// The number of allocations made through the global operator new so far.
+// [Not part of Crowther's code. In builds with ADVENT_COUNT_ALLOCATIONS
+// defined, the replacement operator new below counts them, so the
+// allocations made by a piece of code may be measured; otherwise the
+// standard operator new is used, and the count stays 0.]
+#ifdef ADVENT_COUNT_ALLOCATIONS
+constexpr bool counting_allocations = true;
+#else
+constexpr bool counting_allocations = false;
+#endif
+std::atomic<size_t> allocation_count{0};
+
+}// namespace scaffolding
+
+
+#ifdef ADVENT_COUNT_ALLOCATIONS
+void * operator new(std::size_t size)
+{
+    scaffolding::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    for (;;) {
+        if (void * p = std::malloc(size ? size : 1))
+            return p;
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+// (GCC warns that free() is called on memory from operator new when these
+//  are inlined, not seeing that operator new is the malloc() above)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+
+
+
+
+/*
+     ######  ########   #######  ##      ## ######## ##     ## ######## ########  
+    ##    ## ##     ## ##     ## ##  ##  ##    ##    ##     ## ##       ##     ## 
+    ##       ##     ## ##     ## ##  ##  ##    ##    ##     ## ##       ##     ## 
+    ##       ########  ##     ## ##  ##  ##    ##    ######### ######   ########  
+    ##       ##   ##   ##     ## ##  ##  ##    ##    ##     ## ##       ##   ##   
+    ##    ## ##    ##  ##     ## ##  ##  ##    ##    ##     ## ##       ##    ##  
+     ######  ##     ##  #######   ###  ###     ##    ##     ## ######## ##     ## 
+*/
+
+namespace Crowther {
+
+using namespace scaffolding::a5_literals;
+
+// Original Adventure subroutines
+// (These appear after the Adventure END statement in the original code.)
+
+                                                    //         SUBROUTINE SHIFT (VAL,DIST,RES)
+void shift(uint_least64_t val, int dist, uint_least64_t & res)
+{
+                                                    //         IMPLICIT INTEGER (A-Z)
+                                                    //         RES=VAL
+                                                    //         IF(DIST)10,20,30
+                                                    // 10      IDIST=-DIST
                                                     //         DO 11 I=1,IDIST
                                                     //         J = 0
                                                     //         IF (RES.LT.0) J="200000000000
@@ -471,7 +1387,7 @@ DEF_TEST_FUNC(shift)
 
                                                     //         SUBROUTINE GETIN(TWOW,B,C,D)
 void getin(
-        scaffolding::advent_io & io,
+        const std::string & input, // [the line of text ACCEPTed from the user]
         uint_least64_t & twow,  // [0 means one word was input; 1 means at least two words]
         uint_least64_t & b,     // [up to five characters of the first word]
         uint_least64_t & c,     // [up to five characters of the second word (when twow == 1)]
@@ -483,7 +1399,7 @@ void getin(
         9999ULL,04000000000ULL,020000000ULL,0100000ULL,0400ULL,02ULL,0ULL
     };
     uint_least64_t xx, yy, mask;
-    scaffolding::accept_4A5(io, a);                 // 6       ACCEPT 1,(A(I), I=1,4)
+    scaffolding::accept_4A5(input, a);              // 6       ACCEPT 1,(A(I), I=1,4)
     // [Only the first 4 elements of A are initialised?
     // Yet A(5) is referenced below when J=4, SHIFT(A(J+1),...?]
                                                     // 1       FORMAT(4A5)
@@ -541,6 +1457,59 @@ L4: d = a[2];                                       // 4       D=A(2)
                                                     //         RETURN
 };                                                  //         END
 
+// [GETIN reading its input from the given io.]
+void getin(
+        scaffolding::advent_io & io,
+        uint_least64_t & twow,
+        uint_least64_t & b,
+        uint_least64_t & c,
+        uint_least64_t & d)
+{
+    getin(io.getline(), twow, b, c, d);
+}
+
+
+// [Not part of Crowther's code. Do exactly what GETIN does with the given
+//  line, but in one pass over its characters rather than with masks and
+//  shifts. (GETIN only ever looks at the first 20 characters, uppercased
+//  and reduced to 7 bits, followed by the 5 spaces of A(5).)]
+void getin_fast(
+        std::string_view input,
+        uint_least64_t & twow,
+        uint_least64_t & b,
+        uint_least64_t & c,
+        uint_least64_t & d)
+{
+    std::array<char, 25> line;
+    line.fill(' ');
+    const size_t n = std::min<size_t>(input.size(), 20);
+    for (size_t i = 0; i < n; ++i) {
+        const char ch = static_cast<char>(input[i] & 0x7F);
+        // (as std::toupper() on the whole character, before it is reduced to 7 bits)
+        line[i] = (input[i] >= 'a' && input[i] <= 'z') ? static_cast<char>(ch - 'a' + 'A') : ch;
+    }
+    auto word = [&](size_t first) {
+        return scaffolding::a5_swar::pack5(scaffolding::a5_swar::load5(line.data() + first, 5));
+    };
+
+    size_t space = 0;
+    while (space < 20 && line[space] != ' ')
+        ++space;
+    size_t second = space;
+    while (second < 20 && line[second] == ' ')
+        ++second;
+
+    twow = 0;
+    b = word(0);
+    if (space < 5) // (the first word is shorter than 5 characters)
+        b = scaffolding::a5_swar::pack5(scaffolding::a5_swar::load5(line.data(), space));
+    if (second < 20) {
+        twow = 1;
+        c = word(second);
+    }
+    d = word(5);
+}
+
 DEF_TEST_FUNC(getin)
 {
     class advent_io_getin_test : public scaffolding::advent_io {
@@ -591,12 +1560,57 @@ DEF_TEST_FUNC(getin)
     }
 }
 
+DEF_TEST_FUNC(getin_fast)
+{
+    // getin_fast() must give exactly what getin() gives
+    auto same = [](const std::string & input) {
+        uint_least64_t twow{99}, b{99}, c{99}, d{99};
+        getin(input, twow, b, c, d);
+        uint_least64_t twow_fast{99}, b_fast{99}, c_fast{99}, d_fast{99};
+        getin_fast(input, twow_fast, b_fast, c_fast, d_fast);
+        return twow == twow_fast && b == b_fast && c == c_fast && d == d_fast;
+    };
+    for (const char * input : {
+            "", " ", "xyzzy", "get lamp", "WHO ARE YOU", "go           west",
+            " leading space", "Supercalifragilisticexpialidocious          ",
+            "abcd efgh", "abcde fghij", "abcdef ghi", "12345678901234567890 x",
+            "1234567890123456789 x", "a\xA0" "b", "\xE1\xC1 \xFF" })
+        TEST_EQUAL(same(input), true);
+
+    // and for every short line of a few telling characters
+    const std::string alphabet{"a Z\xA0\xE1"};
+    std::string input;
+    bool all_same = true;
+    for (int len = 0; len <= 7; ++len) {
+        unsigned combinations = 1;
+        for (int i = 0; i < len; ++i)
+            combinations *= static_cast<unsigned>(alphabet.size());
+        for (unsigned n = 0; n < combinations; ++n) {
+            input.clear();
+            for (unsigned m = n, i = 0; i < static_cast<unsigned>(len); ++i, m /= static_cast<unsigned>(alphabet.size()))
+                input += alphabet[m % alphabet.size()];
+            if (input.size() > 2) // (and some runs of spaces)
+                input.insert(2, std::string(len / 2, ' '));
+            all_same = all_same && same(input);
+        }
+    }
+    TEST_EQUAL(all_same, true);
+}
+
+DEF_BENCH_FUNC(getin)
+{
+    uint_least64_t twow, b, c, d;
+    const std::string input{"get lamp"};
+    BENCHMARK("getin", 1000000, [&] { getin(input, twow, b, c, d); return b ^ c ^ d; });
+    BENCHMARK("getin_fast", 1000000, [&] { getin_fast(input, twow, b, c, d); return b ^ c ^ d; });
+}
+
 
                                                     //         SUBROUTINE SPEAK(IT)
 void speak(
     scaffolding::advent_io & io,
     const std::array<int, 101> & rtext,
-    const std::vector<std::array<uint_least64_t, 23>> & lline,
+    const std::array<std::array<uint_least64_t, 23>, 1001> & lline,
     int it)
 {
     auto typ = [&](
@@ -625,22 +1639,30 @@ L999: typ(lline.at(kkt), 3, lline.at(kkt)[2]);      // 999     TYPE 998, (LLINE(
 
 
                                                     //         SUBROUTINE YES(X,Y,Z,YEA)
-void yes(
-    scaffolding::advent_io & io,
-    const std::array<int, 101> & rtext,
-    const std::vector<std::array<uint_least64_t, 23>> & lline,
-    int x,          // [index of text of question to be asked]
+// [YES is split in two at its call to GETIN so that a game may wait for the
+//  user's reply without blocking: yes_ask() asks the question and yes_answer()
+//  acts on the reply. See Crowther::session. The given speak(it) does what
+//  CALL SPEAK(IT) does.]
+template <typename speak_function>
+void yes_ask(
+    speak_function speak,
+    int x)          // [index of text of question to be asked]
+{
+                                                    //         IMPLICIT INTEGER(A-Z)
+    speak(x);                                       //         CALL SPEAK(X)
+}
+
+template <typename speak_function>
+void yes_answer(
+    speak_function speak,
+    const std::string & reply, // [the user's reply to the question]
     int y,          // [index of text of response if user doesn't say no]
     int z,          // [index of text of response if user says no]
     int & yea)      // [0: user said no; 1: user didn't say no]
 {
-    auto speak = [&](int it) { Crowther::speak(io, rtext, lline, it); };
-
-    uint_least64_t junk, ia1, ib1;                  //         IMPLICIT INTEGER(A-Z)
-    speak(x);                                       //         CALL SPEAK(X)
-    getin(io, junk, ia1, junk, ib1);                //         CALL GETIN(JUNK,IA1,JUNK,IB1)
-                                                    //         IF(IA1.EQ.'NO'.OR.IA1.EQ.'N') GOTO 1
-    if (ia1 == scaffolding::as_a5("NO") || ia1== scaffolding::as_a5("N")) goto L1;
+    uint_least64_t junk, ia1, ib1;
+    getin_fast(reply, junk, ia1, junk, ib1);        //         CALL GETIN(JUNK,IA1,JUNK,IB1)
+    if (ia1 == "NO"_a5 || ia1 == "N"_a5) goto L1;   //         IF(IA1.EQ.'NO'.OR.IA1.EQ.'N') GOTO 1
     yea = 1;                                        //         YEA=1
     if (y != 0) speak(y);                           //         IF(Y.NE.0) CALL SPEAK(Y)
     return;                                         //         RETURN
@@ -663,16 +1685,330 @@ L1: yea = 0;                                        // 1       YEA=0
     ##     ## ########     ###    ######## ##    ##    ##     #######  ##     ## ########
 */
 
-// Adventure -- recoded in C++ as directly as seemed reasonable
-// (Original source: http://www.icynic.com/~don/jerz/advf4.77-03-31)
+// [An entry in the vocabulary index, below.]
+struct vocab_entry {
+    uint_least64_t word;    // [a keyword from atab]
+    int index;              // [the first i for which atab[i] == word]
+
+    bool operator==(const vocab_entry &) const = default;
+};
+
+// [Not part of Crowther's code. travel[kk] unpacked: to is LL/1024 and motion
+//  is MOD(LL,1024), where LL is the absolute value of travel[kk], and last is
+//  set if travel[kk] is negative, i.e. it is the last entry for its location.]
+struct travel_entry {
+    uint_least16_t to;
+    uint_least16_t motion : 10;
+    uint_least16_t last : 1;
+
+    bool operator==(const travel_entry &) const = default;
+};
+
+// [Not part of Crowther's code. ktab[i] unpacked: value is MOD(KTAB(I),1000)
+//  and type is KTAB(I)/1000, i.e. 0 motion, 1 object, 2 action, 3 message.]
+struct keyword_entry {
+    int_least16_t value;
+    int_least8_t type;
+
+    bool operator==(const keyword_entry &) const = default;
+};
+
+// The tables Adventure reads from its data file. [This struct is not part of
+// Crowther's code. Once loaded these tables are never written, so they may be
+// loaded once and used for any number of games. The struct holds no pointers,
+// so it may be saved and restored as a plain binary image.]
+struct world {
+    std::array<std::array<uint_least64_t, 23>, 1001> lline{}; // [description text table]
+    std::array<int, 301>  ltext{}, stext{}, key{}, cond{};
+    std::array<int, 201>  btext{};
+    std::array<int, 101>  rtext{};
+    std::array<int, 1001> ktab{}, travel{};
+    std::array<uint_least64_t, 1001> atab{}; // [keyword table, each keyword is 1..5 7-bit characters]
+
+    // [Not part of Crowther's code. The keywords in vocab[0..vocab_size-1]
+    //  sorted on word, one entry per distinct word. vocab_end is the i of
+    //  the ktab[i] == -1 end marker, or 1001 if there is no end marker.]
+    std::array<vocab_entry, 1000> vocab{};
+    int vocab_size{};
+    int vocab_end{};
+
+    // [Not part of Crowther's code. travel_index[loc][k] is where the walk
+    //  of the travel table at label 9 would stop for motion k at location
+    //  loc: +kk if it stops at travel[kk] with a match (label 10), -kk if it
+    //  stops at the last entry travel[kk] without one (label 11), or 0 if
+    //  the walk must be done the long way (no entries, or it runs off the
+    //  end of the table).]
+    static constexpr int travel_motions = 128;
+    std::array<std::array<int_least16_t, travel_motions>, 301> travel_index{};
+
+    // [Not part of Crowther's code. travel and ktab unpacked, so the walk at
+    //  label 9 and the keyword lookup at label 2025 use no division; together
+    //  the two tables are 8K. See pack_tables().]
+    std::array<travel_entry, 1001> travel_packed{};
+    std::array<keyword_entry, 1001> ktab_packed{};
+
+    // [Not part of Crowther's code. Each line of lline as it is typed, i.e.
+    //  LLINE(KK,3..LLINE(KK,2)) in A5 format followed by a newline, starts at
+    //  text[text_line[kk]]. The lines are in order, so the lines of a message
+    //  are contiguous; the last line of each is followed by the blank line
+    //  typed after it, so a whole message is typed at once. message_last[kk]
+    //  is the last line of the message line kk is in. See line_text() and
+    //  message_block().]
+    std::array<char, 1001 * (20 * 5 + 2)> text{};
+    std::array<int, 1002> text_line{};
+    std::array<int_least16_t, 1001> message_last{};
+
+    // [Not part of Crowther's code. A hash of the tables read from the data
+    //  file, to identify the data a saved game was played with.]
+    uint_least64_t fingerprint{};
+
+    bool operator==(const world &) const = default;
+};
+
+
+// [Not part of Crowther's code. Build the vocabulary index from ktab/atab.]
+void index_vocabulary(world & w)
+{
+    w.vocab_end = 1;
+    while (w.vocab_end <= 1000 && w.ktab[w.vocab_end] != -1)
+        ++w.vocab_end;
+
+    w.vocab_size = 0;
+    for (int i = 1; i < w.vocab_end; ++i)
+        w.vocab[w.vocab_size++] = vocab_entry{w.atab[i], i};
+    // (stable, so that of several entries for the same word the first is kept)
+    const auto first = w.vocab.begin(), last = first + w.vocab_size;
+    std::stable_sort(first, last, [](const vocab_entry & x, const vocab_entry & y) {
+        return x.word < y.word;
+    });
+    auto end = std::unique(first, last, [](const vocab_entry & x, const vocab_entry & y) {
+        return x.word == y.word;
+    });
+    std::fill(end, last, vocab_entry{});
+    w.vocab_size = static_cast<int>(end - first);
+}
+
+
+// [Not part of Crowther's code. Return where the walk of the travel table
+//      9       LL=TRAVEL(KK)
+//              IF(LL.LT.0) LL=-LL
+//              IF(1.EQ.MOD(LL,1024))GOTO 10
+//              IF(K.EQ.MOD(LL,1024))GOTO 10
+//              IF(TRAVEL(KK).LT.0)GOTO 11
+//              KK=KK+1
+//              GOTO 9
+//  starting at kk stops for motion k, encoded as for world::travel_index.]
+int walk_travel(const world & w, int kk, int k)
+{
+    for (; kk >= 1 && kk <= 1000; ++kk) {
+        const int ll = w.travel[kk] < 0 ? -w.travel[kk] : w.travel[kk];
+        if (1 == (ll % 1024) || k == (ll % 1024))
+            return kk;
+        if (w.travel[kk] < 0)
+            return -kk;
+    }
+    return 0;
+}
+
+
+// [Not part of Crowther's code. Build the travel index from key/travel.]
+void index_travel(world & w)
+{
+    for (int loc = 0; loc <= 300; ++loc) {
+        for (int k = 0; k < world::travel_motions; ++k)
+            w.travel_index[loc][k] = w.key[loc] == 0
+                ? 0 : static_cast<int_least16_t>(walk_travel(w, w.key[loc], k));
+    }
+}
+
+
+// [Not part of Crowther's code. Build world::travel_packed and
+//  world::ktab_packed from travel/ktab.]
+void pack_tables(world & w)
+{
+    for (int kk = 0; kk <= 1000; ++kk) {
+        const int ll = w.travel[kk] < 0 ? -w.travel[kk] : w.travel[kk];
+        if (ll / 1024 > UINT_LEAST16_MAX)
+            throw scaffolding::adventure_exception("load(): travel table value out of range");
+        auto & entry = w.travel_packed[kk];
+        entry.to = static_cast<uint_least16_t>(ll / 1024);
+        entry.motion = static_cast<uint_least16_t>(ll % 1024);
+        entry.last = w.travel[kk] < 0;
+    }
+    for (int i = 0; i <= 1000; ++i) {
+        if (w.ktab[i] / 1000 < INT_LEAST8_MIN || w.ktab[i] / 1000 > INT_LEAST8_MAX)
+            throw scaffolding::adventure_exception("load(): keyword table value out of range");
+        w.ktab_packed[i].value = static_cast<int_least16_t>(w.ktab[i] % 1000);
+        w.ktab_packed[i].type = static_cast<int_least8_t>(w.ktab[i] / 1000);
+    }
+}
+
+
+// [Not part of Crowther's code. Set w.fingerprint to the FNV-1a hash of the
+//  tables read from the data file.]
+void fingerprint_tables(world & w)
+{
+    uint_least64_t h = 0xCBF29CE484222325ULL;
+    auto hash = [&](const auto & table) {
+        const auto * p = reinterpret_cast<const unsigned char *>(table.data());
+        for (size_t n = 0; n < sizeof(table); ++n)
+            h = (h ^ p[n]) * 0x100000001B3ULL;
+    };
+    hash(w.lline);
+    hash(w.ltext);
+    hash(w.stext);
+    hash(w.key);
+    hash(w.cond);
+    hash(w.btext);
+    hash(w.rtext);
+    hash(w.ktab);
+    hash(w.travel);
+    hash(w.atab);
+    w.fingerprint = h;
+}
+
+
+// [Not part of Crowther's code. Decode the text in lline into world::text.]
+void render_text(world & w)
+{
+    int n = 0;
+    for (int kk = 0; kk <= 1000; ++kk) {
+        w.text_line[kk] = n;
+        const auto & line = w.lline[kk];
+        if (line[2] >= 3) {
+            const auto chars = scaffolding::unpack_a5(&line.at(3), std::min<uint_least64_t>(line[2], 22) - 2);
+            for (char c : chars.view())
+                w.text.at(n++) = c;
+        }
+        w.text.at(n++) = '\n';
+        if (line[1] == 0 || kk == 1000)
+            w.text.at(n++) = '\n'; // (the blank line after a message)
+    }
+    w.text_line[1001] = n;
+    for (int kk = 1000; kk >= 0; --kk)
+        w.message_last[kk] = static_cast<int_least16_t>(
+            w.lline[kk][1] != 0 && kk < 1000 ? w.message_last[kk + 1] : kk);
+}
+
+
+// [Not part of Crowther's code. Return line kk of lline as type_20a5()
+//  would type it.]
+std::string_view line_text(const world & w, int kk)
+{
+    const int first = w.text_line.at(kk);
+    const int last = w.text_line.at(kk + 1) - (w.message_last.at(kk) == kk ? 1 : 0);
+    return std::string_view(w.text.data() + first, last - first);
+}
+
+
+// [Not part of Crowther's code. Return all the lines of the message that
+//  line kk is in, from line kk, i.e. up to and including the first line kk'
+//  for which LLINE(KK',1) is 0, followed by a blank line: what Crowther's
+//  SPEAK types, and what the loops at labels 4 and 2005 type with the
+//  TYPE 6 and TYPE 2007 after them.]
+std::string_view message_block(const world & w, int kk)
+{
+    const int first_char = w.text_line.at(kk), last_char = w.text_line.at(w.message_last.at(kk) + 1);
+    return std::string_view(w.text.data() + first_char, last_char - first_char);
+}
+
+
+// [Not part of Crowther's code. As message_block(), without the blank line.]
+std::string_view message_text(const world & w, int kk)
+{
+    const std::string_view block = message_block(w, kk);
+    return block.substr(0, block.size() - 1);
+}
+
+
+// [Not part of Crowther's code. Do what speak(io, w.rtext, w.lline, it) does,
+//  using the pre-rendered text.]
+void speak(scaffolding::advent_io & io, const world & w, int it)
+{
+    const int kkt = w.rtext.at(it);
+    if (kkt == 0) return;
+    io.type(message_block(w, kkt));
+}
+
+
+// [Not part of Crowther's code. Return the i at which the loop
+//      2023    DO 2024 I=1,1000
+//              IF(KTAB(I).EQ.-1)GOTO 3000
+//              IF(ATAB(I).EQ.A)GOTO 2025
+//      2024    CONTINUE
+//  would leave the loop: the first i with atab[i] == a, or if there are
+//  none, the i of the end marker, or if there is no end marker, 1001.]
+int find_word(const world & w, uint_least64_t a)
+{
+    const auto first = w.vocab.begin(), last = first + w.vocab_size;
+    const auto p = std::lower_bound(first, last, a, [](const vocab_entry & x, uint_least64_t word) {
+        return x.word < word;
+    });
+    return (p != last && p->word == a) ? p->index : w.vocab_end;
+}
+
+// [A loaded world is immutable and may be shared by any number of sessions,
+//  each of which holds a reference to it; it is freed with the last one.]
+using shared_world = std::shared_ptr<const world>;
+
+// [Not part of Crowther's code. The time taken by, and the allocations made
+//  in, each stage of load(), added up over any number of loads. (The
+//  allocations are counted only with ADVENT_COUNT_ALLOCATIONS defined.)]
+struct load_profile {
+    enum stage {
+        text,       // [labels 1004..1012: the long, short, state and event texts]
+        map,        // [labels 1013..1019: the travel table]
+        keywords,   // [labels 1020..1022: the vocabulary]
+        cond,       // [labels 1100..1103: the location conditions]
+        indexes,    // [the tables derived from those read: see index_vocabulary() etc.]
+        stages
+    };
+    static constexpr const char * stage_names[stages] = {
+        "text", "map", "keywords", "cond", "indexes"
+    };
+
+    std::array<uint_least64_t, stages> nanoseconds{};
+    std::array<size_t, stages> allocations{};
+    size_t loads = 0;
+};
+
+
+// Read the Adventure data file into the given world, exactly as Crowther's
+// program does at labels 1002..1023. [If given a profile, the time taken
+// by, and the allocations made in, each stage are added to it.]
 template <typename input_stream>
-void adventure(
+void load(
     input_stream & advdat,          // Adventure data file stream
-    scaffolding::advent_io & io)    // communication with outside world
+    scaffolding::advent_io & io,    // (used only if the data file is too big)
+    world & w,
+    load_profile * profile = nullptr)
 {
     using excpt = scaffolding::adventure_exception;
     auto pause = [&](const char * msg) { scaffolding::pause(io, msg); };
 
+    // [Not part of Crowther's code. End the current stage, if any, and
+    //  start the next, if any, adding the time and count of allocations to
+    //  the profile.]
+    int current_stage = -1;
+    auto stage_start = std::chrono::steady_clock::now();
+    size_t stage_allocations = 0;
+    auto stage = [&](int next) {
+        if (!profile)
+            return;
+        const auto now = std::chrono::steady_clock::now();
+        const size_t allocations = scaffolding::allocation_count.load(std::memory_order_relaxed);
+        if (current_stage >= 0) {
+            profile->nanoseconds[current_stage] += static_cast<uint_least64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - stage_start).count());
+            profile->allocations[current_stage] += allocations - stage_allocations;
+        }
+        else
+            ++profile->loads;
+        current_stage = next;
+        stage_start = now;
+        stage_allocations = allocations;
+    };
+
 
     // read a line from the map data table to mimic FORMAT(12G), as in
     //      1014    READ(1,1015)JKIND,LKIND,(TK(L),L=1,10)
@@ -681,12 +2017,11 @@ void adventure(
         if (!(advdat >> jkind))
             throw excpt("rdmap(): read jkind failed");
         std::string buf;
-        std::getline(advdat, buf);
-        std::istringstream iss(buf);
-        if (!(iss >> lkind))
+        std::string_view line = scaffolding::rest_of_line(advdat, buf);
+        if (!scaffolding::read_int(line, lkind))
             lkind = 0;
         int i = 1;
-        while (i <= 10 && (iss >> tk[i]))
+        while (i <= 10 && scaffolding::read_int(line, tk[i]))
             ++i;
         while (i <= 10)
             tk[i++] = 0;
@@ -699,19 +2034,15 @@ void adventure(
         if (!(advdat >> j))
             throw excpt("rdtext(): read jkind failed");
         std::string buf;
-        std::getline(advdat, buf);
-        while (!buf.empty() && buf[0] == ' ')
-            buf.erase(0, 1);
+        std::string_view line = scaffolding::rest_of_line(advdat, buf);
+        // (the blanks after the number, tabs included, are skipped as G input does)
+        while (!line.empty() && (line[0] == ' ' || line[0] == '\t'))
+            line.remove_prefix(1);
         t[0] = 9999;
         t[1] = 0;
         t[2] = 0;
-        int n = 3;
-        while (n < 23 && !buf.empty()) {
-            t[n++] = scaffolding::as_a5(buf.substr(0, 5));
-            buf.erase(0, 5);
-        }
-        while (n < 23)
-            t[n++] = scaffolding::as_a5("");
+        const auto words = scaffolding::pack_a5(line); // (space filled)
+        std::copy(words.word.begin(), words.word.end(), t.begin() + 3);
     };
 
     // read a line from the keyword table to mimic FORMAT(G,A5), as in
@@ -721,112 +2052,45 @@ void adventure(
         if (!(advdat >> k))
             throw excpt("rdkey(): read k failed");
         std::string buf;
-        std::getline(advdat, buf);
-        while (!buf.empty() && buf[0] == ' ')
-            buf.erase(0, 1);
-        a = scaffolding::as_a5(buf.substr(0, 5));
+        std::string_view line = scaffolding::rest_of_line(advdat, buf);
+        while (!line.empty() && (line[0] == ' ' || line[0] == '\t'))
+            line.remove_prefix(1);
+        a = scaffolding::as_a5(line.substr(0, 5));
     };
 
 
-                                                    //       C ADVENTURES
-                                                    //         IMPLICIT INTEGER(A-Z)
-    int attack, dtot, id, idark, idetal, idwarf,
-        ifirst, ikind, iid, il, ilk, ilong, itemp, iwest;
-    int j, jkind, jobj, jspk(9999), jverb(9999), k(9999),
-        kk, kq, ktem, l, lkind, ll, loc, lold(9999), ltrubl,
-        stick, temp, yea;
-    uint_least64_t a, b, twowds, wd2;
-
-                                                    //         REAL RAN
-                                                    //         COMMON RTEXT,LLINE
-                                                    //         DIMENSION IOBJ(300),ICHAIN(100),IPLACE(100)
-                                                    //       1 ,IFIXED(100),COND(300),PROP(100),ABB(300),LLINE(1000,22)
-                                                    //       2 ,LTEXT(300),STEXT(300),KEY(300),DEFAULT(300),TRAVEL(1000)
-                                                    //       3 ,TK(25),KTAB(1000),ATAB(1000),BTEXT(200),DSEEN(10)
-                                                    //       4 ,DLOC(10),ODLOC(10),DTRAV(20),RTEXT(100),JSPKT(100)
-                                                    //       5 ,IPLT(100),IFIXT(100)
-    std::array<int, 11>   dloc{},dseen{},odloc{};
-    std::array<int, 26>   tk{};
-    std::array<int, 101>  ichain{},ifixed{},iplace{},prop{},rtext{};
-    std::array<int, 201>  btext{};
-    std::array<int, 301>  abb{},cond{},default_{},iobj{},key{},ltext{},stext{};
-    std::vector<int> ktab(1001), travel(1001);
-    std::vector<std::array<uint_least64_t, 23>> lline(1001); // [description text table]
-    std::vector<uint_least64_t> atab(1001); // [keyword table, each keyword is 1..5 7-bit characters]
-
-    auto speak = [&](int it) { Crowther::speak(io, rtext, lline, it); };
-    auto yes = [&](int x, int y, int z, int & yea) { Crowther::yes(io, rtext, lline, x, y, z, yea); };
-
-
-
-
-                                                    //       C READ THE PARAMETERS
-
-                                                    //         IF(SETUP.NE.0) GOTO 1
-                                                    //         SETUP=1
-    // [SETUP is not explicitly initialised prior to the IF. Presumably the PDP-10
-    // FORTRAN system could be relied upon to zero-initialise variables? Anyway,
-    // how could execution return to this point to ask whether SETUP was non-zero?]
+    int i, ikind, jkind, k, kk, l, lkind;           //         IMPLICIT INTEGER(A-Z)
+    std::array<int, 26> tk{};
+    auto & lline = w.lline;
+    auto & ltext = w.ltext;
+    auto & stext = w.stext;
+    auto & key = w.key;
+    auto & cond = w.cond;
+    auto & btext = w.btext;
+    auto & rtext = w.rtext;
+    auto & ktab = w.ktab;
+    auto & travel = w.travel;
+    auto & atab = w.atab;
 
-    constexpr int keys      = 1;                    //         KEYS=1
-    constexpr int lamp      = 2;                    //         LAMP=2
-    constexpr int grate     = 3;                    //         GRATE=3
-    //           [cage      = 4]
-    constexpr int rod       = 5;                    //         ROD=5
-    //           [steps     = 6]
-    constexpr int bird      = 7;                    //         BIRD=7
-    constexpr int nugget    = 10;                   //         NUGGET=10
-    constexpr int snake     = 11;                   //         SNAKE=11
-    //           [fissure   = 12]
-    //           [diamonds  = 13]
-    //           [silver    = 14]
-    //           [jewels    = 15]
-    //           [coins     = 16]
-    //           [dwarves   = 17]
-    //           [knife/rock = 18]
-    constexpr int food      = 19;                   //         FOOD=19
-    constexpr int water     = 20;                   //         WATER=20
-    constexpr int axe       = 21;                   //         AXE=21
-    //           [knife     = 22]
-    //           [chest     = 23]
-                                                    //         DATA(JSPKT(I),I=1,16)/24,29,0,31,0,31,38,38,42,42,43,46,77,71
-                                                    //       1 ,73,75/
-    std::array<int, 101> jspkt = {
-        9999,24,29,0,31,0,31,38,38,42,42,43,46,77,71,73,75
-    };
-                                                    //         DATA(IPLT(I),I=1,20)/3,3,8,10,11,14,13,9,15,18,19,17,27,28,29
-                                                    //       1 ,30,0,0,3,3/
-    // [Initial location of objects. E.g. iplt[keys] = room 3, i.e. in the building]
-    std::array<int, 101> iplt = {
-        9999,3,3,8,10,11,14,13,9,15,18,19,17,27,28,29,30,0,0,3,3
-    };
-                                                    //         DATA(IFIXT(I),I=1,20)/0,0,1,0,0,1,0,1,1,0,1,1,0,0,0,0,0,0,0,0/
-    std::array<int, 101> ifixt = {
-        9999,0,0,1,0,0,1,0,1,1,0,1,1
-    };
-                                                    //         DATA(DTRAV(I),I=1,15)/36,28,19,30,62,60,41,27,17,15,19,28,36
-                                                    //       1 ,300,300/
-    std::array<int, 21> dtrav = {
-        9999,36,28,19,30,62,60,41,27,17,15,19,28,36,300,300
-    };
                                                     //         DO 1001 I=1,300
                                                     //         STEXT(I)=0
                                                     //         IF(I.LE.200) BTEXT(I)=0
                                                     //         IF(I.LE.100)RTEXT(I)=0
                                                     // 1001    LTEXT(I)=0
-    int i = 1;                                      //         I=1
+    stage(load_profile::text); // [not part of Crowther's code]
+    i = 1;                                          //         I=1
                                                     //         CALL IFILE(1,'TEXT')
 L1002: if (!(advdat >> ikind))                      // 1002    READ(1,1003) IKIND
         throw excpt("L1002: read ikind failed");    // 1003    FORMAT(G)
                                                     //         GOTO(1100,1004,1004,1013,1020,1004,1004)(IKIND+1)
     switch (ikind) {
     case 0: goto L1100; // [end of data]
-    case 1: goto L1004; // [long descriptions]
-    case 2: goto L1004; // [short descriptions]
-    case 3: goto L1013; // [map data]
-    case 4: goto L1020; // [keywords]
-    case 5: goto L1004; // [game state descriptions]
-    case 6: goto L1004; // [events]
+    case 1: stage(load_profile::text); goto L1004;      // [long descriptions]
+    case 2: stage(load_profile::text); goto L1004;      // [short descriptions]
+    case 3: stage(load_profile::map); goto L1013;       // [map data]
+    case 4: stage(load_profile::keywords); goto L1020;  // [keywords]
+    case 5: stage(load_profile::text); goto L1004;      // [game state descriptions]
+    case 6: stage(load_profile::text); goto L1004;      // [events]
     default: throw excpt("L1002: unexpected ikind value");
     }
 
@@ -901,25 +2165,13 @@ L1020: for (int iu = 1; iu <= 1000; ++iu) {         // 1020    DO 1022 IU=1,1000
     }                                               // 1022    CONTINUE
     pause("TOO MANY WORDS");                        //         PAUSE 'TOO MANY WORDS'
     // [Falling into the code below doesn't look logical. See my comment above.]
-                                                    //
-                                                    //
-                                                    //       C TRAVEL = NEG IF LAST THIS SOURCE + DEST*1024 + KEYWORD
                                                     //
                                                     //       C COND  = 1 IF LIGHT,  2 IF DON'T ASK QUESTION
-                                                    // 
-                                                    // 
-                                                    // 
-                                                    // 
-                                                    // 
-L1100: for (i = 1; i <= 100; ++i) {                 // 1100    DO 1101 I=1,100
-        iplace[i] = iplt[i];                        //         IPLACE(I)=IPLT(I)
-        ifixed[i] = ifixt[i];                       //         IFIXED(I)=IFIXT(I)
-        // [ichain was zero initialised]            // 1101    ICHAIN(I)=0
-    }                                               //
+    // [COND is never changed after this point so it is set up here, with the
+    //  other tables, rather than at label 1100 with the objects.]
+L1100:stage(load_profile::cond); // [not part of Crowther's code]
                                                     //         DO 1102 I=1,300
-    // [abb, cond & iobj were zero initialised]     //         COND(I)=0
-                                                    //         ABB(I)=0
-                                                    // 1102    IOBJ(I)=0
+    // [cond was zero initialised]                  //         COND(I)=0
     for (i = 1; i <= 10; ++i)                       //         DO 1103 I=1,10
         cond[i] = 1; // [locs 1..10 have light]     // 1103    COND(I)=1
     cond[16] = 2;                                   //         COND(16)=2
@@ -933,56 +2185,692 @@ L1100: for (i = 1; i <= 100; ++i) {                 // 1100    DO 1101 I=1,100
     cond[31] = 2;                                   //         COND(31)=2
     cond[32] = 2;                                   //         COND(32)=2
     cond[79] = 2;                                   //         COND(79)=2
-                                                    //
-    for (i = 1; i <= 100; ++i) {                    //         DO 1107 I=1,100
-        ktem = iplace[i];                           //         KTEM=IPLACE(I)
-        if (ktem == 0) continue;                    //         IF(KTEM.EQ.0)GOTO 1107
-        if (iobj.at(ktem) != 0) goto L1104;         //         IF(IOBJ(KTEM).NE.0) GOTO 1104
-        iobj.at(ktem) = i;                          //         IOBJ(KTEM)=I
-        continue;                                   //         GO TO 1107
-L1104:  ktem = iobj.at(ktem);                       // 1104    KTEM=IOBJ(KTEM)
-L1105:  if (ichain.at(ktem) != 0) goto L1106;       // 1105    IF(ICHAIN(KTEM).NE.0) GOTO 1106
-        ichain.at(ktem) = i;                        //         ICHAIN(KTEM)=I
-        continue;                                   //         GOTO 1107
-L1106:  ktem = ichain.at(ktem);                     // 1106    KTEM=ICHAIN(KTEM)
-        goto L1105;                                 //         GOTO 1105
-    }                                               // 1107    CONTINUE
-    idwarf = 0;                                     //         IDWARF=0
-    ifirst = 1;                                     //         IFIRST=1
-    iwest = 0;                                      //         IWEST=0
-    ilong = 1;                                      //         ILONG=1
-    idetal = 0;                                     //         IDETAL=0
-    pause("INIT DONE");                             //         PAUSE 'INIT DONE'
-                                                    // 
-                                                    // 
-                                                    // 
-    // [65:"WELCOME TO ADVENTURE!!  WOULD YOU LIKE INSTRUCTIONS?"]
-    yes(65, 1, 0, yea);                             // 1       CALL YES(65,1,0,YEA)
-    l = 1;                                          //         L=1
-    loc = 1;                                        //         LOC=1
-L2:
-    io.trace_location(l); // [This line is not part of Crowther's code.]
 
-    // [The following line is not in Crowther's code. It was added to avoid
-    //  an infinite loop. See note at L25.]
-    if (l == 26) pause("GAME OVER");
+    stage(load_profile::indexes); // [not part of Crowther's code]
+    index_vocabulary(w); // [not part of Crowther's code]
+    index_travel(w);     // [not part of Crowther's code]
+    pack_tables(w);      // [not part of Crowther's code]
+    render_text(w);      // [not part of Crowther's code]
+    fingerprint_tables(w); // [not part of Crowther's code]
+    stage(-1);           // [not part of Crowther's code]
+}
 
-    for (i = 1; i <= 3; ++i) {                      // 2       DO 73 I=1,3
+
+// [Not part of Crowther's code. Choices that don't change how the game plays.]
+struct session_options {
+    bool travel_index = true;   // [find destinations with world::travel_index]
+    uint_least64_t seed = 1;    // [seed for the game's pseudo-random number generator]
+};
+
+
+// [Not part of Crowther's code. The state of a game in progress, saved by
+//  session::save() and restored by session::restore().]
+constexpr size_t session_snapshot_size = 779;
+using session_snapshot = std::array<unsigned char, session_snapshot_size>;
+
+
+// [Not part of Crowther's code. What a game is doing after a step.]
+enum class session_status {
+    awaiting_input, // [waiting for the next line of input]
+    terminated,     // [the user typed X at a PAUSE; the game is over for good]
+    failed          // [a step threw an exception, so the game was ended; only
+                    //  a session_scheduler reports this]
+};
+
+
+// [Not part of Crowther's code. The objects at each location, in the order
+//  Crowther's IOBJ and ICHAIN chains would hold them, kept in one dense
+//  array: the objects at each location are one run of it, and the runs are
+//  in order of location. Listing a room's objects reads one short run of
+//  bytes rather than following a chain from object to object; putting an
+//  object first or last in a location's list, or taking one out, moves the
+//  objects after it along by one.]
+class location_objects {
+public:
+    static constexpr int locations = 300, objects = 100;
+
+    // the objects at the given location, first to last
+    std::span<const uint_least8_t> at(int loc) const
+    {
+        check(loc);
+        return {objects_.data() + start_[loc], objects_.data() + start_[loc + 1]};
+    }
+
+    // put the given object first, or last, in the given location's list
+    void push_front(int loc, int obj) { check(loc); insert(start_[loc], loc, obj); }
+    void push_back(int loc, int obj) { check(loc); insert(start_[loc + 1], loc, obj); }
+
+    // take the given object out of the given location's list; throw if it isn't there
+    void erase(int loc, int obj)
+    {
+        const auto here = at(loc);
+        const auto found = std::find(here.begin(), here.end(), obj);
+        if (found == here.end())
+            throw scaffolding::adventure_exception("location_objects: object not at location");
+        const size_t n = start_[loc] + static_cast<size_t>(found - here.begin());
+        const size_t end = start_[locations + 1];
+        std::copy(objects_.begin() + n + 1, objects_.begin() + end, objects_.begin() + n);
+        objects_[end - 1] = 0;
+        for (int l = loc + 1; l <= locations + 1; ++l)
+            --start_[l];
+    }
+
+    // all the objects at any location, location by location
+    std::span<const uint_least8_t> all() const { return {objects_.data(), start_[locations + 1]}; }
+
+    // replace the lists with the given objects, location by location, the
+    // given number of them at each of locations 1, 2...
+    void assign(std::span<const uint_least8_t> lists, std::span<const uint_least8_t> counts)
+    {
+        clear();
+        size_t end = 0;
+        for (size_t loc = 1; loc <= counts.size(); ++loc) {
+            end += counts[loc - 1];
+            if (loc > static_cast<size_t>(locations) || end > lists.size() || end > static_cast<size_t>(objects))
+                throw scaffolding::adventure_exception("location_objects: no room for object");
+        }
+        for (size_t loc = 1; loc <= static_cast<size_t>(locations); ++loc)
+            start_[loc + 1] = static_cast<uint_least8_t>(start_[loc] + (loc <= counts.size() ? counts[loc - 1] : 0));
+        if (std::any_of(lists.begin(), lists.begin() + end, [](int obj) { return obj < 1 || obj > objects; }))
+            throw scaffolding::adventure_exception("location_objects: no such object");
+        std::copy(lists.begin(), lists.begin() + end, objects_.begin());
+    }
+
+    void clear() { objects_.fill(0); start_.fill(0); }
+
+private:
+    static void check(int loc)
+    {
+        if (loc < 0 || loc > locations)
+            throw scaffolding::adventure_exception("location_objects: no such location");
+    }
+
+    void insert(size_t n, int loc, int obj)
+    {
+        const size_t end = start_[locations + 1];
+        if (end == objects || obj < 1 || obj > objects)
+            throw scaffolding::adventure_exception("location_objects: no room for object");
+        std::copy_backward(objects_.begin() + n, objects_.begin() + end, objects_.begin() + end + 1);
+        objects_[n] = static_cast<uint_least8_t>(obj);
+        for (int l = loc + 1; l <= locations + 1; ++l)
+            ++start_[l];
+    }
+
+    std::array<uint_least8_t, objects> objects_{};        // [0 after the last]
+    std::array<uint_least8_t, locations + 2> start_{};    // [where each location's run starts; the last is the end]
+};
+
+
+// A game of Adventure. [This class is not part of Crowther's code. The
+// variables that were local to Crowther's program are members of a session,
+// so that a game may stop when it needs a line of input and carry on from
+// where it left off when it's given one. Many games may then be played on
+// one thread, without any of them blocking on I/O.]
+class session {
+public:
+    explicit session(shared_world w, session_options options = {})
+    : world_(std::move(w)), w_(*world_), options_(options), prng_(options.seed) {}
+
+    // Start the game; return the output up to the first request for input.
+    std::string start();
+
+    // Give the game the next line of input; return the output up to its
+    // next request for input.
+    std::string step(const std::string & input_line);
+
+    // As above, but communicate with the outside world through the given io.
+    // (The io's getline() is never called.) Return the game's status: once
+    // terminated, further steps do nothing. No exception is thrown to end
+    // a game.
+    session_status start(scaffolding::advent_io & io);
+    session_status step(std::string_view input_line, scaffolding::advent_io & io);
+
+    session_status status() const
+    {
+        return label_ == terminated_label ? session_status::terminated : session_status::awaiting_input;
+    }
+
+    // Return the state of the game between steps, or restore a game to the
+    // state it was in when saved. The game must be played with the same
+    // data file tables; restore() throws if it isn't.
+    session_snapshot save() const;
+    void restore(const session_snapshot & snapshot);
+
+    // Return a hash of the state of the game between steps, for finding
+    // games in the same state: the hash of save(), but leaving out the
+    // variables the game always sets before it next reads them.
+    uint_least64_t state_hash() const;
+
+    // Return the ACCEPT or PAUSE the game is waiting at (1..14), 0 if it
+    // hasn't started or -1 if it's over.
+    int resume_point() const { return label_; }
+
+    // Return the tables the game is played with.
+    const shared_world & tables() const { return world_; }
+
+private:
+    static constexpr int terminated_label = -1;
+
+    void run(scaffolding::advent_io & io);
+
+    shared_world world_;        // [keeps w_ alive for the life of the session]
+    const world & w_;
+    const session_options options_;
+    scaffolding::prng prng_;    // [the game's own random numbers; see advent_io::ran()]
+    int label_ = 0;             // [where run() is to resume; 0: not started, -1: terminated]
+    bool have_input_ = false;   // [true if input_ has yet to be consumed]
+    std::string input_;         // [the most recent line of input]
+
+                                                    //       C ADVENTURES
+                                                    //         IMPLICIT INTEGER(A-Z)
+    int attack{}, dtot{}, i{}, id{}, idark{}, idetal{}, idwarf{},
+        ifirst{}, iid{}, il{}, ilk{}, ilong{}, itemp{}, iwest{};
+    int j{}, jobj{}, jspk{9999}, jverb{9999}, k{9999},
+        kk{}, kq{}, ktem{}, l{}, ll{}, loc{}, lold{9999}, ltrubl{},
+        stick{}, temp{}, yea{};
+    uint_least64_t a{}, b{}, twowds{}, wd2{};
+
+                                                    //         REAL RAN
+                                                    //         COMMON RTEXT,LLINE
+                                                    //         DIMENSION IOBJ(300),ICHAIN(100),IPLACE(100)
+                                                    //       1 ,IFIXED(100),COND(300),PROP(100),ABB(300),LLINE(1000,22)
+                                                    //       2 ,LTEXT(300),STEXT(300),KEY(300),DEFAULT(300),TRAVEL(1000)
+                                                    //       3 ,TK(25),KTAB(1000),ATAB(1000),BTEXT(200),DSEEN(10)
+                                                    //       4 ,DLOC(10),ODLOC(10),DTRAV(20),RTEXT(100),JSPKT(100)
+                                                    //       5 ,IPLT(100),IFIXT(100)
+    // [These hold only locations (-1..300), object numbers (0..100) and small
+    //  counts, so are 16 bits wide. Each object's IPLACE, IFIXED and PROP are
+    //  kept together in one 6-byte record, so what the game tests of an
+    //  object is on one cache line; iplace(i), ifixed(i) and prop(i) are its
+    //  fields. IOBJ and ICHAIN, the chains of objects at each location, are
+    //  replaced by the dense lists of a location_objects, in the same order.]
+    using small = int_least16_t;
+    struct object_state {
+        small place, fixed, prop;
+    };
+    std::array<small, 11>   dloc{},dseen{},odloc{};
+    std::array<small, 301>  abb{},default_{};
+    std::array<object_state, 101> objects_{};
+    location_objects objects_at_;
+    small & iplace(int obj) { return objects_.at(obj).place; }
+    small & ifixed(int obj) { return objects_.at(obj).fixed; }
+    small & prop(int obj) { return objects_.at(obj).prop; }
+    small iplace(int obj) const { return objects_.at(obj).place; }
+    small ifixed(int obj) const { return objects_.at(obj).fixed; }
+    small prop(int obj) const { return objects_.at(obj).prop; }
+    // [The remaining tables are in the world, w_.]
+};
+
+
+std::string session::start()
+{
+    std::string output;
+    scaffolding::advent_io_string io(output);
+    start(io);
+    return output;
+}
+
+std::string session::step(const std::string & input_line)
+{
+    std::string output;
+    scaffolding::advent_io_string io(output);
+    step(input_line, io);
+    return output;
+}
+
+session_status session::start(scaffolding::advent_io & io)
+{
+    label_ = 0;
+    have_input_ = false;
+    run(io);
+    return status();
+}
+
+session_status session::step(std::string_view input_line, scaffolding::advent_io & io)
+{
+    if (label_ == terminated_label)
+        return session_status::terminated;
+    if (label_ == 0)
+        run(io);
+    input_ = input_line;
+    have_input_ = true;
+    run(io);
+    return status();
+}
+
+
+// [A snapshot is a fixed-size little-endian record:
+//      "ADVS", format version (2 bytes), 2 unused bytes
+//      the world fingerprint (8 bytes)
+//      label_ (1 byte), 3 unused bytes
+//      each int scalar (2 bytes each, but ll, a travel entry, 3 bytes)
+//      a, b, twowds and wd2 (8 bytes each)
+//      the generator state (32 bytes)
+//      dloc[1..10], odloc[1..10] (2 bytes each), dseen[1..10] (1 byte each)
+//      the objects at each location, first to last, location by location
+//          (100 bytes, 0 after the last)
+//      ifixed and iplace [1..100] (each location, -1..300, plus 1 in 9 bits:
+//          the low 8 bits 1 byte each, then the ninth bits, 13 bytes)
+//      prop [1..100] (1 byte each)
+//      the number of objects at each location, and abb
+//          [1..snapshot_locations] (1 byte each)
+//  The location tables are saved for the first snapshot_locations
+//  locations only, the number Crowther's data use. The DEFAULT table is
+//  never written so is not saved. save() throws if any value won't fit its
+//  place in the record.]
+namespace {
+constexpr unsigned char session_snapshot_magic[4] = {'A', 'D', 'V', 'S'};
+constexpr unsigned session_snapshot_version = 4;
+constexpr int snapshot_locations = 79;
+
+// (where the scalars are in the record, in the order save() puts them)
+constexpr size_t snapshot_ints = 30;
+constexpr std::array<int, snapshot_ints> snapshot_int_bytes = {
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2};
+constexpr size_t snapshot_ints_offset = 20;
+constexpr size_t snapshot_int_offset(size_t index)
+{
+    size_t offset = snapshot_ints_offset;
+    for (size_t x = 0; x < index; ++x)
+        offset += static_cast<size_t>(snapshot_int_bytes[x]);
+    return offset;
+}
+constexpr size_t snapshot_words_offset = snapshot_int_offset(snapshot_ints);
+constexpr size_t snapshot_word_bytes = 8, snapshot_words = 4;
+constexpr size_t snapshot_i = 2, snapshot_k = 18;   // [i and k are ints[2] and ints[18] in save()]
+
+// (the bytes of a table of 100 locations in 9 bits each)
+constexpr size_t snapshot_location_table_bytes = 100 + (100 + 7) / 8;
+
+static_assert(session_snapshot_size == snapshot_words_offset + snapshot_words * snapshot_word_bytes
+    + 32 + 10 * (2 + 2 + 1) + 100 + 2 * snapshot_location_table_bytes + 100 + 2 * snapshot_locations);
+}
+
+session_snapshot session::save() const
+{
+    session_snapshot result{};
+    size_t n = 0;
+    auto put = [&](long long value, int bytes) {
+        const long long lo = bytes == 8 ? LLONG_MIN : -(1LL << (bytes * 8 - 1));
+        const long long hi = bytes == 8 ? LLONG_MAX : (1LL << (bytes * 8 - 1)) - 1;
+        if (value < lo || value > hi)
+            throw scaffolding::adventure_exception("session::save(): value out of range");
+        for (int b = 0; b < bytes; ++b)
+            result.at(n++) = static_cast<unsigned char>(static_cast<unsigned long long>(value) >> (b * 8));
+    };
+    auto put_u64 = [&](uint_least64_t value) {
+        for (int b = 0; b < 8; ++b)
+            result.at(n++) = static_cast<unsigned char>(value >> (b * 8));
+    };
+    auto put_table = [&](const auto & table, int first, int last, int bytes) {
+        for (int x = 1; x < static_cast<int>(table.size()); ++x) {
+            if (x < first || x > last) {
+                if (table[x] != 0)
+                    throw scaffolding::adventure_exception("session::save(): value out of range");
+            }
+            else
+                put(table[x], bytes);
+        }
+    };
+    auto put_locations = [&](small object_state::* field) {
+        const size_t high_bits = n + 100;
+        for (int x = 1; x <= 100; ++x) {
+            const int location = objects_[x].*field;
+            if (location < -1 || location > 510)
+                throw scaffolding::adventure_exception("session::save(): value out of range");
+            const unsigned value = static_cast<unsigned>(location + 1);
+            result.at(n++) = static_cast<unsigned char>(value & 0xFF);
+            result.at(high_bits + (x - 1) / 8) |= static_cast<unsigned char>((value >> 8) << ((x - 1) % 8));
+        }
+        n += snapshot_location_table_bytes - 100;
+    };
+
+    for (unsigned char c : session_snapshot_magic)
+        result.at(n++) = c;
+    put(session_snapshot_version, 2);
+    n += 2;
+    put_u64(w_.fingerprint);
+    put(label_, 1);
+    n += 3;
+    const std::array<int, snapshot_ints> ints = {
+        attack, dtot, i, id, idark, idetal, idwarf, ifirst, iid, il, ilk, ilong, itemp, iwest,
+        j, jobj, jspk, jverb, k, kk, kq, ktem, l, ll, loc, lold, ltrubl, stick, temp, yea};
+    if (n != snapshot_ints_offset)
+        throw scaffolding::adventure_exception("session::save(): bad snapshot size");
+    for (size_t x = 0; x < snapshot_ints; ++x)
+        put(ints[x], snapshot_int_bytes[x]);
+    for (uint_least64_t value : {a, b, twowds, wd2})
+        put_u64(value);
+    for (uint_least64_t value : prng_.state())
+        put_u64(value);
+    put_table(dloc, 1, 10, 2);
+    put_table(odloc, 1, 10, 2);
+    put_table(dseen, 1, 10, 1);
+    const size_t objects_at = n;
+    for (const int obj : objects_at_.all())
+        put(obj, 1);
+    n = objects_at + 100;
+    put_locations(&object_state::fixed);
+    put_locations(&object_state::place);
+    for (int x = 1; x <= 100; ++x)
+        put(prop(x), 1);
+    size_t listed = 0;
+    for (int x = 1; x <= snapshot_locations; ++x) {
+        put(static_cast<long long>(objects_at_.at(x).size()), 1);
+        listed += objects_at_.at(x).size();
+    }
+    if (listed != objects_at_.all().size())
+        throw scaffolding::adventure_exception("session::save(): value out of range");
+    put_table(abb, 1, snapshot_locations, 1);
+    if (n != result.size())
+        throw scaffolding::adventure_exception("session::save(): bad snapshot size");
+    return result;
+}
+
+void session::restore(const session_snapshot & snapshot)
+{
+    size_t n = 0;
+    auto get = [&](int bytes) {
+        unsigned long long value = 0;
+        for (int b = 0; b < bytes; ++b)
+            value |= static_cast<unsigned long long>(snapshot.at(n++)) << (b * 8);
+        if (bytes < 8 && (value >> (bytes * 8 - 1)) != 0)
+            value |= ~0ULL << (bytes * 8); // (sign extend)
+        return static_cast<long long>(value);
+    };
+    auto get_u64 = [&]() { return static_cast<uint_least64_t>(get(8)); };
+    auto get_table = [&](auto & table, int first, int last, int bytes) {
+        table.fill(0);
+        for (int x = first; x <= last; ++x)
+            table[x] = static_cast<int>(get(bytes));
+    };
+    auto get_locations = [&](small object_state::* field) {
+        const size_t high_bits = n + 100;
+        for (int x = 1; x <= 100; ++x) {
+            const unsigned high = (snapshot.at(high_bits + (x - 1) / 8) >> ((x - 1) % 8)) & 1u;
+            objects_[x].*field = static_cast<small>(static_cast<int>(snapshot.at(n++) | high << 8) - 1);
+        }
+        n += snapshot_location_table_bytes - 100;
+    };
+
+    if (!std::equal(std::begin(session_snapshot_magic), std::end(session_snapshot_magic), snapshot.begin()))
+        throw scaffolding::adventure_exception("session::restore(): not a session snapshot");
+    n += 4;
+    if (get(2) != session_snapshot_version)
+        throw scaffolding::adventure_exception("session::restore(): incompatible session snapshot");
+    n += 2;
+    if (get_u64() != w_.fingerprint)
+        throw scaffolding::adventure_exception("session::restore(): snapshot is of a game with different data");
+    const int label = static_cast<int>(get(1));
+    n += 3;
+    const std::array<int *, snapshot_ints> ints = {
+        &attack, &dtot, &i, &id, &idark, &idetal, &idwarf, &ifirst, &iid, &il, &ilk, &ilong, &itemp, &iwest,
+        &j, &jobj, &jspk, &jverb, &k, &kk, &kq, &ktem, &l, &ll, &loc, &lold, &ltrubl, &stick, &temp, &yea};
+    for (size_t x = 0; x < snapshot_ints; ++x)
+        *ints[x] = static_cast<int>(get(snapshot_int_bytes[x]));
+    for (uint_least64_t * value : {&a, &b, &twowds, &wd2})
+        *value = get_u64();
+    std::array<uint_least64_t, 4> state;
+    for (auto & value : state)
+        value = get_u64();
+    prng_.set_state(state);
+    get_table(dloc, 1, 10, 2);
+    get_table(odloc, 1, 10, 2);
+    get_table(dseen, 1, 10, 1);
+    std::array<uint_least8_t, 100> objects_at;
+    for (auto & obj : objects_at)
+        obj = snapshot.at(n++);
+    objects_ = {};
+    get_locations(&object_state::fixed);
+    get_locations(&object_state::place);
+    for (int x = 1; x <= 100; ++x)
+        prop(x) = static_cast<small>(get(1));
+    std::array<uint_least8_t, snapshot_locations> counts;
+    for (auto & count : counts)
+        count = snapshot.at(n++);
+    objects_at_.assign(objects_at, counts);
+    get_table(abb, 1, snapshot_locations, 1);
+    default_.fill(0);
+    label_ = label;
+    have_input_ = false;
+    input_.clear();
+}
+
+
+uint_least64_t session::state_hash() const
+{
+    session_snapshot snapshot = save();
+    if (label_ == 6) {
+        // [at ACCEPT 6, the command prompt, the words read and i and k are
+        //  set before they're read; see label 2020]
+        for (const size_t index : {snapshot_i, snapshot_k})
+            std::fill_n(snapshot.begin() + snapshot_int_offset(index), snapshot_int_bytes[index], 0);
+        std::fill_n(snapshot.begin() + snapshot_words_offset, snapshot_words * snapshot_word_bytes, 0); // [a, b, twowds, wd2]
+    }
+    uint_least64_t h = 0xCBF29CE484222325ULL;
+    for (const unsigned char c : snapshot)
+        h = (h ^ c) * 0x100000001B3ULL;
+    return h;
+}
+
+
+// [Not part of Crowther's code. Wait for a line of input: record where to
+//  resume and return from run(). When the game is given the line, run()
+//  jumps to R<n>, here, and the game carries on with the line in input_.]
+#define ADVENT_ACCEPT(n)                                \
+    label_ = n;                                         \
+R##n:                                                   \
+    if (!have_input_) return;                           \
+    have_input_ = false
+
+// [Not part of Crowther's code. PAUSE, waiting for the user's reply as above.
+//  If the user terminates the program, the session is over.]
+#define ADVENT_PAUSE(n, msg)                            \
+    pause_begin(msg);                                   \
+    for (;;) {                                          \
+        ADVENT_ACCEPT(n);                               \
+        const auto reply = pause_answer();              \
+        if (reply == scaffolding::pause_reply::resume)  \
+            break;                                      \
+        if (reply == scaffolding::pause_reply::terminate) { \
+            label_ = terminated_label;                  \
+            return;                                     \
+        }                                               \
+    }
+
+
+// Adventure -- recoded in C++ as directly as seemed reasonable
+// (Original source: http://www.icynic.com/~don/jerz/advf4.77-03-31)
+void session::run(
+    scaffolding::advent_io & io)    // communication with outside world
+{
+    auto pause_begin = [&](const char * msg) { scaffolding::pause_begin(io, msg); };
+    auto pause_answer = [&]() { return scaffolding::pause_answer(io, input_); };
+    auto ran = [&](int call_site) { return io.ran(call_site, prng_); };
+
+    const auto & ltext = w_.ltext;
+    const auto & stext = w_.stext;
+    const auto & key = w_.key;
+    const auto & cond = w_.cond;
+    const auto & btext = w_.btext;
+    const auto & ktab = w_.ktab;
+    const auto & ptravel = w_.travel_packed; // [travel and ktab unpacked]
+    const auto & pktab = w_.ktab_packed;
+
+    // [Not part of Crowther's code. Time the phases of the game if the io asks
+    //  for it. The timing object ends the current phase whenever run() returns.]
+    using instrumentation = scaffolding::instrumentation;
+    instrumentation * const instruments = io.instruments();
+    auto phase = [&](instrumentation::phase p) { if (instruments) instruments->enter(p); };
+    struct phase_timing {
+        instrumentation * const instruments;
+        explicit phase_timing(instrumentation * i) : instruments(i) { if (instruments) instruments->enter(instrumentation::other); }
+        ~phase_timing() { if (instruments) instruments->stop(); }
+    } const timing(instruments);
+
+    // [Not part of Crowther's code. Mark each label as the game passes it if
+    //  the io asks for it.]
+    scaffolding::label_set * const labels = io.labels_reached();
+    auto hit = [&](int n) { if (labels) labels->set(static_cast<size_t>(n)); };
+
+    auto speak = [&](int it) {
+        if (!instruments)
+            return Crowther::speak(io, w_, it);
+        const auto since = instrumentation::clock::now();
+        Crowther::speak(io, w_, it);
+        instruments->record(instrumentation::speak, since);
+    };
+    auto yes_ask = [&](int x) { Crowther::yes_ask(speak, x); };
+    auto yes_answer = [&](int y, int z, int & yea) { Crowther::yes_answer(speak, input_, y, z, yea); };
+
+
+
+
+                                                    //       C READ THE PARAMETERS
+
+                                                    //         IF(SETUP.NE.0) GOTO 1
+                                                    //         SETUP=1
+    // [SETUP is not explicitly initialised prior to the IF. Presumably the PDP-10
+    // FORTRAN system could be relied upon to zero-initialise variables? Anyway,
+    // how could execution return to this point to ask whether SETUP was non-zero?]
+
+    constexpr int keys      = 1;                    //         KEYS=1
+    constexpr int lamp      = 2;                    //         LAMP=2
+    constexpr int grate     = 3;                    //         GRATE=3
+    //           [cage      = 4]
+    constexpr int rod       = 5;                    //         ROD=5
+    //           [steps     = 6]
+    constexpr int bird      = 7;                    //         BIRD=7
+    constexpr int nugget    = 10;                   //         NUGGET=10
+    constexpr int snake     = 11;                   //         SNAKE=11
+    //           [fissure   = 12]
+    //           [diamonds  = 13]
+    //           [silver    = 14]
+    //           [jewels    = 15]
+    //           [coins     = 16]
+    //           [dwarves   = 17]
+    //           [knife/rock = 18]
+    constexpr int food      = 19;                   //         FOOD=19
+    constexpr int water     = 20;                   //         WATER=20
+    constexpr int axe       = 21;                   //         AXE=21
+    //           [knife     = 22]
+    //           [chest     = 23]
+                                                    //         DATA(JSPKT(I),I=1,16)/24,29,0,31,0,31,38,38,42,42,43,46,77,71
+                                                    //       1 ,73,75/
+    static constexpr std::array<int, 101> jspkt = {
+        9999,24,29,0,31,0,31,38,38,42,42,43,46,77,71,73,75
+    };
+                                                    //         DATA(IPLT(I),I=1,20)/3,3,8,10,11,14,13,9,15,18,19,17,27,28,29
+                                                    //       1 ,30,0,0,3,3/
+    // [Initial location of objects. E.g. iplt[keys] = room 3, i.e. in the building]
+    static constexpr std::array<int, 101> iplt = {
+        9999,3,3,8,10,11,14,13,9,15,18,19,17,27,28,29,30,0,0,3,3
+    };
+                                                    //         DATA(IFIXT(I),I=1,20)/0,0,1,0,0,1,0,1,1,0,1,1,0,0,0,0,0,0,0,0/
+    static constexpr std::array<int, 101> ifixt = {
+        9999,0,0,1,0,0,1,0,1,1,0,1,1
+    };
+                                                    //         DATA(DTRAV(I),I=1,15)/36,28,19,30,62,60,41,27,17,15,19,28,36
+                                                    //       1 ,300,300/
+    static constexpr std::array<int, 21> dtrav = {
+        9999,36,28,19,30,62,60,41,27,17,15,19,28,36,300,300
+    };
+                                                    //
+
+    switch (label_) {       // [resume where we left off; see ADVENT_ACCEPT]
+        case  0: break;
+        case  1: goto R1;
+        case  2: goto R2;
+        case  3: goto R3;
+        case  4: goto R4;
+        case  5: goto R5;
+        case  6: goto R6;
+        case  7: goto R7;
+        case  8: goto R8;
+        case  9: goto R9;
+        case 10: goto R10;
+        case 11: goto R11;
+        case 12: goto R12;
+        case 13: goto R13;
+        case 14: goto R14;
+        default: throw scaffolding::adventure_exception("session: bad resume label");
+    }
+                                                    //
+                                                    //       C TRAVEL = NEG IF LAST THIS SOURCE + DEST*1024 + KEYWORD
+                                                    //
+                                                    //       C COND  = 1 IF LIGHT,  2 IF DON'T ASK QUESTION
+                                                    // 
+                                                    // 
+                                                    // 
+                                                    // 
+                                                    // 
+L1100:hit(1100); for (i = 1; i <= 100; ++i) {       // 1100    DO 1101 I=1,100
+        iplace(i) = iplt[i];                        //         IPLACE(I)=IPLT(I)
+        ifixed(i) = ifixt[i];                       //         IFIXED(I)=IFIXT(I)
+        // [the chains are replaced by objects_at_] // 1101    ICHAIN(I)=0
+    }                                               //
+                                                    //         DO 1102 I=1,300
+    // [abb was zero initialised]                   //         COND(I)=0
+    // [cond was set up in load() above]            //         ABB(I)=0
+                                                    // 1102    IOBJ(I)=0
+                                                    //         DO 1103 I=1,10
+                                                    //          ...
+                                                    //         COND(79)=2
+                                                    //
+    for (i = 1; i <= 100; ++i) {                    //         DO 1107 I=1,100
+        ktem = iplace(i);                           //         KTEM=IPLACE(I)
+        if (ktem == 0) continue;                    //         IF(KTEM.EQ.0)GOTO 1107
+        // [object i goes last in the list at ktem, //         IF(IOBJ(KTEM).NE.0) GOTO 1104
+        //  as it would go last in the chain]       //         IOBJ(KTEM)=I
+        objects_at_.push_back(ktem, i);             //         GO TO 1107
+                                                    // 1104    KTEM=IOBJ(KTEM)
+                                                    // 1105    IF(ICHAIN(KTEM).NE.0) GOTO 1106
+                                                    //         ICHAIN(KTEM)=I
+                                                    //         GOTO 1107
+                                                    // 1106    KTEM=ICHAIN(KTEM)
+                                                    //         GOTO 1105
+    }                                               // 1107    CONTINUE
+    idwarf = 0;                                     //         IDWARF=0
+    ifirst = 1;                                     //         IFIRST=1
+    iwest = 0;                                      //         IWEST=0
+    ilong = 1;                                      //         ILONG=1
+    idetal = 0;                                     //         IDETAL=0
+    ADVENT_PAUSE(1, "INIT DONE");                   //         PAUSE 'INIT DONE'
+                                                    // 
+                                                    // 
+                                                    // 
+    // [65:"WELCOME TO ADVENTURE!!  WOULD YOU LIKE INSTRUCTIONS?"]
+    yes_ask(65);                                    // 1       CALL YES(65,1,0,YEA)
+    ADVENT_ACCEPT(2);
+    yes_answer(1, 0, yea);
+    l = 1;                                          //         L=1
+    loc = 1;                                        //         LOC=1
+L2:hit(2);
+    io.trace_location(l); // [This line is not part of Crowther's code.]
+    phase(instrumentation::other); // [nor this]
+
+    // [The following line is not in Crowther's code. It was added to avoid
+    //  an infinite loop. See note at L25.]
+    if (l == 26) { ADVENT_PAUSE(3, "GAME OVER"); }
+
+    for (i = 1; i <= 3; ++i) {                      // 2       DO 73 I=1,3
         if (odloc[i]!=l || dseen[i]==0) continue;   //         IF(ODLOC(I).NE.L.OR.DSEEN(I).EQ.0)GOTO 73
         l = loc;                                    //         L=LOC
         // [2:"A LITTLE DWARF WITH A BIG KNIFE BLOCKS YOUR WAY."]
         speak(2);                                   //         CALL SPEAK(2)
         goto L74;                                   //         GOTO 74
     }                                               // 73      CONTINUE
-L74:loc = l;                                        // 74      LOC=L
+L74:hit(74);loc = l;                                // 74      LOC=L
+    phase(instrumentation::dwarves); // [not part of Crowther's code]
                                                     //
                                                     //       C DWARF STUFF
                                                     //
     if (idwarf != 0) goto L60;                      //         IF(IDWARF.NE.0) GOTO 60
     if (loc == 15) idwarf = 1;                      //         IF(LOC.EQ.15) IDWARF=1
     goto L71;                                       //         GOTO 71
-L60:if (idwarf != 1) goto L63;                      // 60      IF(IDWARF.NE.1)GOTO 63
-    if (io.ran(60) > 0.05) goto L71;                //         IF(RAN(QZ).GT.0.05) GOTO 71
+L60:hit(60);if (idwarf != 1) goto L63;              // 60      IF(IDWARF.NE.1)GOTO 63
+    if (ran(60) > 0.05) goto L71;                   //         IF(RAN(QZ).GT.0.05) GOTO 71
     idwarf = 2;                                     //         IDWARF=2
     for (i = 1; i <= 3; ++i) {                      //         DO 61 I=1,3
         dloc[i] = 0;                                //         DLOC(I)=0
@@ -991,12 +2879,12 @@ L60:if (idwarf != 1) goto L63;                      // 60      IF(IDWARF.NE.1)GO
     }
     // [3:"A LITTLE DWARF...THREW A LITTLE AXE AT YOU WHICH MISSED..."]
     speak(3);                                       //         CALL SPEAK(3)
-    ichain.at(axe) = iobj.at(loc);                  //         ICHAIN(AXE)=IOBJ(LOC)
-    iobj[loc] = axe;                                //         IOBJ(LOC)=AXE
-    iplace[axe] = loc;                              //         IPLACE(AXE)=LOC
+    objects_at_.push_front(loc, axe);               //         ICHAIN(AXE)=IOBJ(LOC)
+                                                    //         IOBJ(LOC)=AXE
+    iplace(axe) = loc;                              //         IPLACE(AXE)=LOC
     goto L71;                                       //         GOTO 71
                                                     //
-L63:++idwarf;                                       // 63      IDWARF=IDWARF+1
+L63:hit(63);++idwarf;                               // 63      IDWARF=IDWARF+1
     attack = 0;                                     //         ATTACK=0
     dtot = 0;                                       //         DTOT=0
     stick = 0;                                      //         STICK=0
@@ -1009,12 +2897,12 @@ L63:++idwarf;                                       // 63      IDWARF=IDWARF+1
         dloc[i] = dtrav.at(i * 2 + idwarf - 8);     //         DLOC(I)=DTRAV(I*2+IDWARF-8)
         dseen[i] = 0;                               //         DSEEN(I)=0
         if (dloc[i]!=loc && odloc[i]!=loc) continue;//         IF(DLOC(I).NE.LOC.AND.ODLOC(I).NE.LOC) GOTO 66
-L65:    dseen[i] = 1;                               // 65      DSEEN(I)=1
+L65:hit(65);    dseen[i] = 1;                       // 65      DSEEN(I)=1
         dloc[i] = loc;                              //         DLOC(I)=LOC
         ++dtot;                                     //         DTOT=DTOT+1
         if (odloc[i] != dloc[i]) continue;          //         IF(ODLOC(I).NE.DLOC(I)) GOTO 66
         ++attack;                                   //         ATTACK=ATTACK+1
-        if (io.ran(65) < 0.1) ++stick;              //         IF(RAN(QZ).LT.0.1) STICK=STICK+1
+        if (ran(65) < 0.1) ++stick;                 //         IF(RAN(QZ).LT.0.1) STICK=STICK+1
     }                                               // 66      CONTINUE
     if (dtot == 0) goto L71;                        //         IF(DTOT.EQ.0) GOTO 71
     if (dtot == 1) goto L75;                        //         IF(DTOT.EQ.1)GOTO 75
@@ -1023,14 +2911,14 @@ L65:    dseen[i] = 1;                               // 65      DSEEN(I)=1
                  " THE ROOM WITH YOU.\n");          //       1  ROOM WITH YOU.',/)
     goto L77;                                       //         GOTO 77
     // [4:"THERE IS A THREATENING LITTLE DWARF IN THE ROOM WITH YOU!"]
-L75:speak(4);                                       // 75      CALL SPEAK(4)
-L77:if (attack == 0) goto L71;                      // 77      IF(ATTACK.EQ.0)GOTO 71
+L75:hit(75);speak(4);                               // 75      CALL SPEAK(4)
+L77:hit(77);if (attack == 0) goto L71;              // 77      IF(ATTACK.EQ.0)GOTO 71
     if (attack == 1) goto L79;                      //         IF(ATTACK.EQ.1)GOTO 79
     io.type(" "); io.type(attack);                  //         TYPE 78,ATTACK
     io.type(" OF THEM THROW KNIVES AT YOU!\n");     // 78      FORMAT(' ',I2,' OF THEM THROW KNIVES AT YOU!',/)
     goto L81;                                       //         GOTO 81
     // [5:"ONE SHARP NASTY KNIFE IS THROWN AT YOU!"]
-L79:speak(5);                                       // 79      CALL SPEAK(5)
+L79:hit(79);speak(5);                               // 79      CALL SPEAK(5)
     // [52:"IT MISSES!" 53:"IT GETS YOU!"]
     speak(52 + stick);                              //         CALL SPEAK(52+STICK)
     switch (stick + 1) {                            //         GOTO(71,83)(STICK+1)
@@ -1038,59 +2926,72 @@ L79:speak(5);                                       // 79      CALL SPEAK(5)
         case 2: goto L83;
         default: break;
     }
-L81:if (stick == 0) goto L69;                       // 81      IF(STICK.EQ.0) GOTO 69
+L81:hit(81);if (stick == 0) goto L69;               // 81      IF(STICK.EQ.0) GOTO 69
     if (stick == 1) goto L82;                       //         IF(STICK.EQ.1)GOTO 82
     io.type(" "); io.type(stick);                   //         TYPE 68,STICK
     io.type(" OF THEM GET YOU.\n");                 // 68      FORMAT(' ',I2,' OF THEM GET YOU.',/)
     goto L83;                                       //         GOTO 83
-L82:speak(6); // [6:"HE GETS YOU!"]                 // 82      CALL SPEAK(6)
-L83:pause("GAMES OVER");                            // 83      PAUSE 'GAMES OVER'
+L82:hit(82);speak(6);                               // [6:"HE GETS YOU!"]                 // 82      CALL SPEAK(6)
+L83:hit(83);ADVENT_PAUSE(4, "GAMES OVER");          // 83      PAUSE 'GAMES OVER'
     goto L71; // [or is it?]                        //         GOTO 71
-L69:speak(7); // [7:"NONE OF THEM HIT YOU!"]        // 69      CALL SPEAK(7)
+L69:hit(69);speak(7);                               // [7:"NONE OF THEM HIT YOU!"]        // 69      CALL SPEAK(7)
                                                     //
                                                     //       C PLACE DESCRIPTOR
                                                     //
                                                     // 
                                                     // 
-L71:kk = stext.at(l);                               // 71      KK=STEXT(L)
+L71:hit(71);kk = stext.at(l);                       // 71      KK=STEXT(L)
+    phase(instrumentation::description); // [not part of Crowther's code]
     if (abb.at(l) == 0 || kk == 0) kk = ltext.at(l);//         IF(ABB(L).EQ.0.OR.KK.EQ.0)KK=LTEXT(L)
     if (kk == 0) goto L7;                           //         IF(KK.EQ.0) GOTO 7
-L4:                                                 // 4       TYPE 5,(LLINE(KK,JJ),JJ=3,LLINE(KK,2))
+    // [The loop types the pre-rendered lines and the blank line after them
+    //  at once, and leaves kk exactly where the loop would have left it.]
+                                                    // 4       TYPE 5,(LLINE(KK,JJ),JJ=3,LLINE(KK,2))
                                                     // 5       FORMAT(20A5)
-    scaffolding::type_20a5(io, lline.at(kk), 3, lline.at(kk)[2]);
-    ++kk;                                           //         KK=KK+1
-    if (lline.at(kk - 1)[1] != 0) goto L4;          //         IF(LLINE(KK-1,1).NE.0) GOTO 4
-    io.type("\n");                                  //         TYPE 6
+    io.type(message_block(w_, kk));                 //         KK=KK+1
+    kk = w_.message_last.at(kk) + 1;                //         IF(LLINE(KK-1,1).NE.0) GOTO 4
+                                                    //         TYPE 6
                                                     // 6       FORMAT(/)
-L7: if (cond.at(l) == 2) goto L8;                   // 7       IF(COND(L).EQ.2)GOTO 8
+L7:hit(7); if (cond.at(l) == 2) goto L8;            // 7       IF(COND(L).EQ.2)GOTO 8
                                                     //         IF(LOC.EQ.33.AND.RAN(QZ).LT.0.25)CALL SPEAK(8)
-    if (loc == 33 && io.ran(7) < 0.25) speak(8);    // [8:"A HOLLOW VOICE SAYS 'PLUGH'"]
+    if (loc == 33 && ran(7) < 0.25) speak(8);       // [8:"A HOLLOW VOICE SAYS 'PLUGH'"]
     j = l;                                          //         J=L
     goto L2000;                                     //         GOTO 2000
                                                     //
                                                     //       C GO GET A NEW LOCATION
                                                     //
-L8: kk = key.at(loc);                               // 8       KK=KEY(LOC)
+L8:hit(8); kk = key.at(loc);                        // 8       KK=KEY(LOC)
+    phase(instrumentation::travel); // [not part of Crowther's code]
     if (kk == 0) goto L19;                          //         IF(KK.EQ.0)GOTO 19
     if (k == 57) goto L32;  // [57:LOOK]            //         IF(K.EQ.57)GOTO 32
     if (k == 67) goto L40;  // [67:CAVE]            //         IF(K.EQ.67)GOTO 40
     if (k ==  8) goto L12;  // [8:BACK]             //         IF(K.EQ.8)GOTO 12
     lold = l;                                       //         LOLD=L
-L9: ll = travel.at(kk);                             // 9       LL=TRAVEL(KK)
-    if (ll < 0) ll = -ll;                           //         IF(LL.LT.0) LL=-LL
-    if (1 == (ll % 1024)) goto L10;                 //         IF(1.EQ.MOD(LL,1024))GOTO 10
-    if (k == (ll % 1024)) goto L10;                 //         IF(K.EQ.MOD(LL,1024))GOTO 10
-    if (travel.at(kk) < 0) goto L11;                //         IF(TRAVEL(KK).LT.0)GOTO 11
+    // [Not part of Crowther's code. Skip the walk if its outcome is indexed.]
+    if (options_.travel_index && k >= 0 && k < world::travel_motions && w_.travel_index[loc][k] != 0) {
+        kk = w_.travel_index[loc][k];
+        const bool found = kk > 0;
+        if (!found) kk = -kk;
+        ll = (ptravel[kk].to << 10) | ptravel[kk].motion;
+        if (found) goto L10;
+        goto L11;
+    }
+    // [The walk reads travel_packed; ll = LL/1024*1024 + MOD(LL,1024).]
+L9:hit(9); ll = ptravel.at(kk).to << 10             // 9       LL=TRAVEL(KK)
+       | ptravel[kk].motion;                        //         IF(LL.LT.0) LL=-LL
+    if (1 == ptravel[kk].motion) goto L10;          //         IF(1.EQ.MOD(LL,1024))GOTO 10
+    if (k == ptravel[kk].motion) goto L10;          //         IF(K.EQ.MOD(LL,1024))GOTO 10
+    if (ptravel[kk].last) goto L11;                 //         IF(TRAVEL(KK).LT.0)GOTO 11
     ++kk;                                           //         KK=KK+1
     goto L9;                                        //         GOTO 9
-L12:temp = lold;                                    // 12      TEMP=LOLD
+L12:hit(12);temp = lold;                            // 12      TEMP=LOLD
     lold = l;                                       //         LOLD=L
     l = temp;                                       //         L=TEMP
     goto L21;                                       //         GOTO 21
-L10:l = ll / 1024;                                  // 10      L=LL/1024
+L10:hit(10);l = ll >> 10;                           // 10      L=LL/1024
     goto L21;                                       //         GOTO 21
     // [12:"I DON'T KNOW HOW TO APPLY THAT WORD HERE."]
-L11:jspk = 12;                                      // 11      JSPK=12
+L11:hit(11);jspk = 12;                              // 11      JSPK=12
     // [43:EAST 44:WEST 45:NORTH 46:SOUTH 29:UP 30:DOWN
     //  9:"THERE IS NO WAY TO GO THAT DIRECTION."]
     if (k >= 43 && k <= 46) jspk = 9;               //         IF(K.GE.43.AND.K.LE.46)JSPK=9
@@ -1110,11 +3011,11 @@ L11:jspk = 12;                                      // 11      JSPK=12
     if (k == 17) jspk = 80;                         //         IF(K.EQ.17)JSPK=80
     speak(jspk);                                    //         CALL SPEAK(JSPK)
     goto L2;                                        //         GOTO 2
-L19:speak(13); // [13:"I DON'T UNDERSTAND THAT!"]   // 19      CALL SPEAK(13)
+L19:hit(19);speak(13);                              // [13:"I DON'T UNDERSTAND THAT!"]   // 19      CALL SPEAK(13)
     l = loc;                                        //         L=LOC
     // [14:"I ALWAYS UNDERSTAND COMPASS DIRECTIONS,..."]
     if (ifirst == 0) speak(14);                     //         IF(IFIRST.EQ.0) CALL SPEAK(14)
-L21:if (l < 300) goto L2;                           // 21      IF(L.LT.300)GOTO 2
+L21:hit(21);if (l < 300) goto L2;                   // 21      IF(L.LT.300)GOTO 2
     il = l - 300 + 1;                               //         IL=L-300+1
                                                     //         GOTO(22,23,24,25,26,31,27,28,29,30,33,34,36,37)IL
     switch (il) {
@@ -1139,62 +3040,62 @@ L21:if (l < 300) goto L2;                           // 21      IF(L.LT.300)GOTO
     }
     goto L2;                                        //         GOTO 2
                                                     //
-L22:l = 6;                                          // 22      L=6
-    if (io.ran(22) > 0.5) l = 5;                    //         IF(RAN(QZ).GT.0.5) L=5
+L22:hit(22);l = 6;                                  // 22      L=6
+    if (ran(22) > 0.5) l = 5;                       //         IF(RAN(QZ).GT.0.5) L=5
     goto L2;                                        //         GOTO 2
-L23:l = 23;                                         // 23      L=23
-    if (prop[grate] != 0) l = 9;                    //         IF(PROP(GRATE).NE.0) L=9
+L23:hit(23);l = 23;                                 // 23      L=23
+    if (prop(grate) != 0) l = 9;                    //         IF(PROP(GRATE).NE.0) L=9
     goto L2;                                        //         GOTO 2
-L24:l = 9;                                          // 24      L=9
-    if (prop[grate] != 0) l = 8;                    //         IF(PROP(GRATE).NE.0)L=8
+L24:hit(24);l = 9;                                  // 24      L=9
+    if (prop(grate) != 0) l = 8;                    //         IF(PROP(GRATE).NE.0)L=8
     goto L2;                                        //         GOTO 2
-L25:l = 20;                                         // 25      L=20
-    if (iplace[nugget] != -1) l = 15;               //         IF(IPLACE(NUGGET).NE.-1)L=15
+L25:hit(25);l = 20;                                 // 25      L=20
+    if (iplace(nugget) != -1) l = 15;               //         IF(IPLACE(NUGGET).NE.-1)L=15
     // [Go into the pit carrying gold and you die! But there is a bug here: the map path
     //  becomes l=20,26,26,26... An infinite loop of "I DON'T UNDERSTAND THAT!"
     //  In this implementation I have added 'if (l == 26) pause("GAME OVER")' at L2 to stop this.]
     goto L2;                                        //         GOTO 2
-L26:l = 22;                                         // 26      L=22
-    if (iplace[nugget] != -1) l = 14;               //         IF(IPLACE(NUGGET).NE.-1) L=14
+L26:hit(26);l = 22;                                 // 26      L=22
+    if (iplace(nugget) != -1) l = 14;               //         IF(IPLACE(NUGGET).NE.-1) L=14
     goto L2;                                        //         GOTO 2
-L27:l = 27;                                         // 27      L=27
-    if (prop[12] == 0) l = 31; //[obj 12 is fissure]//         IF(PROP(12).EQ.0)L=31
+L27:hit(27);l = 27;                                 // 27      L=27
+    if (prop(12) == 0) l = 31; //[obj 12 is fissure]//         IF(PROP(12).EQ.0)L=31
     goto L2;                                        //         GOTO 2
-L28:l = 28;                                         // 28      L=28
-    if (prop[snake] == 0) l = 32;                   //         IF(PROP(SNAKE).EQ.0)L=32
+L28:hit(28);l = 28;                                 // 28      L=28
+    if (prop(snake) == 0) l = 32;                   //         IF(PROP(SNAKE).EQ.0)L=32
     goto L2;                                        //         GOTO 2
-L29:l = 29;                                         // 29      L=29
-    if (prop[snake] == 0) l = 32;                   //         IF(PROP(SNAKE).EQ.0) L=32
+L29:hit(29);l = 29;                                 // 29      L=29
+    if (prop(snake) == 0) l = 32;                   //         IF(PROP(SNAKE).EQ.0) L=32
     goto L2;                                        //         GOTO 2
-L30:l = 30;                                         // 30      L=30
-    if (prop[snake] == 0) l = 32;                   //         IF(PROP(SNAKE).EQ.0) L=32
+L30:hit(30);l = 30;                                 // 30      L=30
+    if (prop(snake) == 0) l = 32;                   //         IF(PROP(SNAKE).EQ.0) L=32
     goto L2;                                        //         GOTO 2
-L31:pause("GAME IS OVER");                          // 31      PAUSE 'GAME IS OVER'
+L31:hit(31);ADVENT_PAUSE(5, "GAME IS OVER");        // 31      PAUSE 'GAME IS OVER'
     goto L1100;                                     //         GOTO 1100
     // [15:"SORRY, BUT I AM NOT ALLOWED TO GIVE MORE DETAIL..."]
-L32:if (idetal < 3) speak(15);                      // 32      IF(IDETAL.LT.3)CALL SPEAK(15)
+L32:hit(32);if (idetal < 3) speak(15);              // 32      IF(IDETAL.LT.3)CALL SPEAK(15)
     ++idetal;                                       //         IDETAL=IDETAL+1
     l = loc;                                        //         L=LOC
     abb.at(l) = 0;                                  //         ABB(L)=0
     goto L2;                                        //         GOTO 2
-L33:l = 8;                                          // 33      L=8
-    if (prop[grate] == 0) l = 9;                    //         IF(PROP(GRATE).EQ.0) L=9
+L33:hit(33);l = 8;                                  // 33      L=8
+    if (prop(grate) == 0) l = 9;                    //         IF(PROP(GRATE).EQ.0) L=9
     goto L2;                                        //         GOTO 2
-L34:if (io.ran(34) > 0.2) goto L35;                 // 34      IF(RAN(QZ).GT.0.2)GOTO 35
+L34:hit(34);if (ran(34) > 0.2) goto L35;            // 34      IF(RAN(QZ).GT.0.2)GOTO 35
     l = 68;                                         //         L=68
     goto L2;                                        //         GOTO 2
-L35:l = 65;                                         // 35      L=65
+L35:hit(35);l = 65;                                 // 35      L=65
     // [56:"YOU HAVE CRAWLED AROUND IN SOME LITTLE HOLES AND WOUND UP BACK IN THE MAIN PASSAGE."]
-L38:speak(56);                                      // 38      CALL SPEAK(56)
+L38:hit(38);speak(56);                              // 38      CALL SPEAK(56)
     goto L2;                                        //         GOTO 2
-L36:if (io.ran(361) > 0.2) goto L35;                // 36      IF(RAN(QZ).GT.0.2)GOTO 35
+L36:hit(36);if (ran(361) > 0.2) goto L35;           // 36      IF(RAN(QZ).GT.0.2)GOTO 35
     l = 39;                                         //         L=39
-    if (io.ran(362) > 0.5) l = 70;                  //         IF(RAN(QZ).GT.0.5)L=70
+    if (ran(362) > 0.5) l = 70;                     //         IF(RAN(QZ).GT.0.5)L=70
     goto L2;                                        //         GOTO 2
-L37:l = 66;                                         // 37      L=66
-    if (io.ran(371) > 0.4) goto L38;                //         IF(RAN(QZ).GT.0.4)GOTO 38
+L37:hit(37);l = 66;                                 // 37      L=66
+    if (ran(371) > 0.4) goto L38;                   //         IF(RAN(QZ).GT.0.4)GOTO 38
     l = 71;                                         //         L=71
-    if (io.ran(372) > 0.25) l = 72;                 //         IF(RAN(QZ).GT.0.25)L=72
+    if (ran(372) > 0.25) l = 72;                    //         IF(RAN(QZ).GT.0.25)L=72
     goto L2;                                        //         GOTO 2
 
 // [There is no GOTO 39 in Crowther's code. The code at L39 would be unreachable.
@@ -1203,13 +3104,13 @@ L37:l = 66;                                         // 37      L=66
 //  Swiss cheese room would cause an uncaught exception crash because l is still 314 at
 //  goto L2. However, it seems reasonable to make the assumption that this is an oversight
 //  and the code that Crowther wrote at L39 should be invoked in this situation.]
-L39:l = 66;                                         // 39      L=66
-    if (io.ran(39) > 0.2) goto L38;                 //         IF(RAN(QZ).GT.0.2)GOTO 38
+L39:hit(39);l = 66;                                 // 39      L=66
+    if (ran(39) > 0.2) goto L38;                    //         IF(RAN(QZ).GT.0.2)GOTO 38
     l = 77;                                         //         L=77
     goto L2;                                        //         GOTO 2
 
     // [57:"I DON'T KNOW WHERE THE CAVE IS,..."]
-L40:if (loc < 8) speak(57);                         // 40      IF(LOC.LT.8)CALL SPEAK(57)
+L40:hit(40);if (loc < 8) speak(57);                 // 40      IF(LOC.LT.8)CALL SPEAK(57)
     // [58:"I NEED MORE DETAILED INSTRUCTIONS TO DO THAT."]
     if (loc >= 8) speak(58);                        //         IF(LOC.GE.8)CALL SPEAK(58)
     l = loc;                                        //         L=LOC
@@ -1220,71 +3121,79 @@ L40:if (loc < 8) speak(57);                         // 40      IF(LOC.LT.8)CALL
                                                     //       C DO NEXT INPUT
                                                     // 
                                                     // 
-L2000:ltrubl = 0;                                   // 2000    LTRUBL=0
+L2000:hit(2000);ltrubl = 0;                         // 2000    LTRUBL=0
     loc = j;                                        //         LOC=J
     abb.at(j) = (abb.at(j) + 1) % 5;                //         ABB(J)=MOD((ABB(J)+1),5)
     idark = 0;                                      //         IDARK=0
     if (cond.at(j) % 2 == 1) goto L2003;            //         IF(MOD(COND(J),2).EQ.1) GOTO 2003
-    if (iplace[2]!=j && iplace[2]!=-1) goto L2001;  //         IF((IPLACE(2).NE.J).AND.(IPLACE(2).NE.-1)) GOTO 2001
-    if (prop[2] == 1) goto L2003;                   //         IF(PROP(2).EQ.1)GOTO 2003
+    if (iplace(2)!=j && iplace(2)!=-1) goto L2001;  //         IF((IPLACE(2).NE.J).AND.(IPLACE(2).NE.-1)) GOTO 2001
+    if (prop(2) == 1) goto L2003;                   //         IF(PROP(2).EQ.1)GOTO 2003
     // [16:"IT IS NOW PITCH BLACK. IF YOU PROCEED YOU WILL LIKELY FALL INTO A PIT."]
-L2001:speak(16);                                    // 2001    CALL SPEAK(16)
+L2001:hit(2001);speak(16);                          // 2001    CALL SPEAK(16)
     idark = 1;                                      //         IDARK=1
                                                     // 
                                                     // 
-L2003:i = iobj.at(j);                               // 2003    I=IOBJ(J)
-L2004:if (i == 0) goto L2011;                       // 2004    IF(I.EQ.0) GOTO 2011
-    if ((i==6||i==9) && iplace[10]==-1) goto L2008; //         IF(((I.EQ.6).OR.(I.EQ.9)).AND.(IPLACE(10).EQ.-1))GOTO 2008
-    ilk = i;                                        //         ILK=I
-    if (prop.at(i) != 0) ilk = i + 100;             //         IF(PROP(I).NE.0) ILK=I+100
-    kk = btext.at(ilk);                             //         KK=BTEXT(ILK)
-    if (kk == 0) goto L2008;                        //         IF(KK.EQ.0) GOTO 2008
-L2005:                                              // 2005    TYPE 2006,(LLINE(KK,JJ),JJ=3,LLINE(KK,2))
+L2003:hit(2003);                                    // 2003    I=IOBJ(J)
+    for (const int obj : objects_at_.at(j)) {
+        i = obj;                                    // 2004    IF(I.EQ.0) GOTO 2011
+        if ((i==6||i==9)&&iplace(10)==-1) continue; //         IF(((I.EQ.6).OR.(I.EQ.9)).AND.(IPLACE(10).EQ.-1))GOTO 2008
+        ilk = i;                                    //         ILK=I
+        if (prop(i) != 0) ilk = i + 100;            //         IF(PROP(I).NE.0) ILK=I+100
+        kk = btext.at(ilk);                         //         KK=BTEXT(ILK)
+        if (kk == 0) continue;                      //         IF(KK.EQ.0) GOTO 2008
+        // [As at label 4, the loop types the whole pre-rendered message at once.]
+                                                    // 2005    TYPE 2006,(LLINE(KK,JJ),JJ=3,LLINE(KK,2))
                                                     // 2006    FORMAT(20A5)
-    scaffolding::type_20a5(io, lline.at(kk), 3, lline.at(kk)[2]);
-    ++kk;                                           //         KK=KK+1
-    if (lline.at(kk-1)[1] != 0) goto L2005;         //         IF(LLINE(KK-1,1).NE.0) GOTO 2005
-    io.type("\n");                                  //         TYPE 2007
+        io.type(message_block(w_, kk));             //         KK=KK+1
+        kk = w_.message_last.at(kk) + 1;            //         IF(LLINE(KK-1,1).NE.0) GOTO 2005
+                                                    //         TYPE 2007
                                                     // 2007    FORMAT(/)
-L2008:i = ichain.at(i);                             // 2008    I=ICHAIN(I)
-    goto L2004;                                     //         GOTO 2004
+    }                                               // 2008    I=ICHAIN(I)
+    i = 0; // [as at the end of the chain]          //         GOTO 2004
+    goto L2011;
                                                     // 
                                                     // 
                                                     // 
                                                     //       C K=1 MEANS ANY INPUT
                                                     // 
                                                     // 
-L2012:a = wd2;                                      // 2012    A=WD2
+L2012:hit(2012);a = wd2;                            // 2012    A=WD2
     b = scaffolding::a5_space;                      //         B=' '
     twowds = 0;                                     //         TWOWDS=0
     goto L2021;                                     //         GOTO 2021
                                                     //
-L2009:k = 54; // [54:"OK"]                          // 2009    K=54
-L2010:jspk = k;                                     // 2010    JSPK=K
-L5200:speak(jspk);                                  // 5200    CALL SPEAK(JSPK)
+L2009:hit(2009);k = 54;                             // [54:"OK"]                          // 2009    K=54
+L2010:hit(2010);jspk = k;                           // 2010    JSPK=K
+L5200:hit(5200);speak(jspk);                        // 5200    CALL SPEAK(JSPK)
                                                     //
-L2011:jverb = 0;                                    // 2011    JVERB=0
+L2011:hit(2011);jverb = 0;                          // 2011    JVERB=0
     jobj = 0;                                       //         JOBJ=0
     twowds = 0;                                     //         TWOWDS=0
                                                     //
-L2020:getin(io, twowds, a, wd2, b);                 // 2020    CALL GETIN(TWOWDS,A,WD2,B)
+L2020:hit(2020);ADVENT_ACCEPT(6);                   // 2020    CALL GETIN(TWOWDS,A,WD2,B)
+    getin_fast(input_, twowds, a, wd2, b);
     k = 70; // [70:"YOUR FEET ARE NOW WET."]        //         K=70
                                                     //         IF(A.EQ.'ENTER'.AND.(WD2.EQ.'STREA'.OR.WD2.EQ.'WATER'))GOTO 2010
-    if (a == scaffolding::as_a5("ENTER") && (wd2 == scaffolding::as_a5("STREA") || wd2 == scaffolding::as_a5("WATER"))) goto L2010;
+    if (a == "ENTER"_a5 && (wd2 == "STREA"_a5 || wd2 == "WATER"_a5)) goto L2010;
                                                     //         IF(A.EQ.'ENTER'.AND.TWOWDS.NE.0)GOTO 2012
-    if (a == scaffolding::as_a5("ENTER") && twowds) goto L2012;
-L2021:if (a!=scaffolding::as_a5("WEST")) goto L2023;// 2021    IF(A.NE.'WEST')GOTO 2023
+    if (a == "ENTER"_a5 && twowds) goto L2012;
+L2021:hit(2021);if (a != "WEST"_a5) goto L2023;     // 2021    IF(A.NE.'WEST')GOTO 2023
     ++iwest;                                        //         IWEST=IWEST+1
     if (iwest != 10) goto L2023;                    //         IF(IWEST.NE.10)GOTO 2023
     // [17:"IF YOU PREFER, SIMPLY TYPE W RATHER THAN WEST."]
     speak(17);                                      //         CALL SPEAK(17)
-L2023:for (i = 1; i <= 1000; ++i) {                 // 2023    DO 2024 I=1,1000
+    // [The loop is replaced by a lookup in the vocabulary index that leaves
+    //  i exactly where the loop would have left it.]
+L2023:hit(2023);phase(instrumentation::vocabulary); // [not part of Crowther's code]
+    i = find_word(w_, a);                           // 2023    DO 2024 I=1,1000
+    if (i <= 1000) {
         if (ktab[i] == -1) goto L3000;              //         IF(KTAB(I).EQ.-1)GOTO 3000
-        if (atab[i] == a) goto L2025;               //         IF(ATAB(I).EQ.A)GOTO 2025
+        goto L2025;                                 //         IF(ATAB(I).EQ.A)GOTO 2025
     }                                               // 2024    CONTINUE
-    pause("ERROR 6");                               //         PAUSE 'ERROR 6'
-L2025:k = ktab.at(i) % 1000;                        // 2025    K=MOD(KTAB(I),1000)
-    kq = ktab.at(i) / 1000 + 1;                     //         KQ=KTAB(I)/1000+1
+    ADVENT_PAUSE(7, "ERROR 6");                     //         PAUSE 'ERROR 6'
+L2025:hit(2025);k = pktab.at(i).value;              // 2025    K=MOD(KTAB(I),1000)
+    phase(instrumentation::other); // [not part of Crowther's code]
+    kq = pktab[i].type + 1;                         //         KQ=KTAB(I)/1000+1
     switch (kq) {                                   //         GOTO (5014,5000,2026,2010)KQ
         case 1: goto L5014; // [process movement]
         case 2: goto L5000; // [process noun]
@@ -1292,12 +3201,12 @@ L2025:k = ktab.at(i) % 1000;                        // 2025    K=MOD(KTAB(I),100
         case 4: goto L2010; // [give advice only]
         default: break;
     }
-    pause("NO NO");                                 //         PAUSE 'NO NO'
-L2026:jverb = k;                                    // 2026    JVERB=K
+    ADVENT_PAUSE(8, "NO NO");                       //         PAUSE 'NO NO'
+L2026:hit(2026);jverb = k;                          // 2026    JVERB=K
     jspk = jspkt.at(jverb);                         //         JSPK=JSPKT(JVERB)
     if (twowds != 0) goto L2028;                    //         IF(TWOWDS.NE.0)GOTO 2028
     if (jobj == 0) goto L2036;                      //         IF(JOBJ.EQ.0)GOTO 2036
-L2027:switch (jverb) {                              // 2027    GOTO(9000,5066,3000,5031,2009,5031,9404,9406,5081,5200,
+L2027:hit(2027);switch (jverb) {                    // 2027    GOTO(9000,5066,3000,5031,2009,5031,9404,9406,5081,5200,
         case  1: goto L9000; // [take]              //       1 5200,5300,5506,5502,5504,5505)JVERB
         case  2: goto L5066; // [drop]
         case  3: goto L3000; // [dummy]
@@ -1316,44 +3225,53 @@ L2027:switch (jverb) {                              // 2027    GOTO(9000,5066,30
         case 16: goto L5505; // [rub]
         default: break;
     }
-    pause("ERROR 5");                               //         PAUSE 'ERROR 5'
+    ADVENT_PAUSE(9, "ERROR 5");                     //         PAUSE 'ERROR 5'
                                                     // 
                                                     // 
-L2028:a = wd2;                                      // 2028    A=WD2
+L2028:hit(2028);a = wd2;                            // 2028    A=WD2
     b = scaffolding::a5_space;                      //         B=' '
     twowds = 0;                                     //         TWOWDS=0
     goto L2023;                                     //         GOTO 2023
                                                     // 
     // [60:"I DON'T KNOW THAT WORD." 61:"WHAT?" 13:"I DON'T UNDERSTAND THAT!"]
-L3000:jspk = 60;                                    // 3000    JSPK=60
-    if (io.ran(30001) > 0.8) jspk = 61;             //         IF(RAN(QZ).GT.0.8)JSPK=61
-    if (io.ran(30002) > 0.8) jspk = 13;             //         IF(RAN(QZ).GT.0.8)JSPK=13
+L3000:hit(3000);jspk = 60;                          // 3000    JSPK=60
+    phase(instrumentation::other); // [not part of Crowther's code]
+    if (ran(30001) > 0.8) jspk = 61;                //         IF(RAN(QZ).GT.0.8)JSPK=61
+    if (ran(30002) > 0.8) jspk = 13;                //         IF(RAN(QZ).GT.0.8)JSPK=13
     speak(jspk);                                    //         CALL SPEAK(JSPK)
     ++ltrubl;                                       //         LTRUBL=LTRUBL+1
     if (ltrubl != 3) goto L2020;                    //         IF(LTRUBL.NE.3)GOTO 2020
                                                     //         IF(J.NE.13.OR.IPLACE(7).NE.13.OR.IPLACE(5).NE.-1)GOTO 2032
-    if (j != 13 || iplace[7] != 13 || iplace[5] != -1) goto L2032;
+    if (j != 13 || iplace(7) != 13 || iplace(5) != -1) goto L2032;
     // [18:"ARE YOU TRYING TO CATCH THE BIRD?" 19:"THE BIRD IS FRIGHTENED RIGHT NOW AND YOU CANNOT CATCH IT" 54:"OK"]
-    yes(18, 19, 54, yea);                           //         CALL YES(18,19,54,YEA)
+    yes_ask(18);                                    //         CALL YES(18,19,54,YEA)
+    ADVENT_ACCEPT(10);
+    yes_answer(19, 54, yea);
     goto L2033;                                     //         GOTO 2033
-L2032:                                              // 2032    IF(J.NE.19.OR.PROP(11).NE.0.OR.IPLACE(7).EQ.-1)GOTO 2034
-    if (j != 19 || prop[11] != 0 || iplace[7] == -1) goto L2034;
+L2032:hit(2032);                                    // 2032    IF(J.NE.19.OR.PROP(11).NE.0.OR.IPLACE(7).EQ.-1)GOTO 2034
+    if (j != 19 || prop(11) != 0 || iplace(7) == -1) goto L2034;
     // [20:"ARE YOU TRYING TO ATTACK OR AVOID THE SNAKE?" 21:"YOU CAN'T KILL THE SNAKE..." 54:"OK"]
-    yes(20, 21, 54, yea);                           //         CALL YES(20,21,54,YEA)
+    yes_ask(20);                                    //         CALL YES(20,21,54,YEA)
+    ADVENT_ACCEPT(11);
+    yes_answer(21, 54, yea);
     goto L2033;                                     //         GOTO 2033
-L2034:if (j != 8 || prop[grate] != 0) goto L2035;   // 2034    IF(J.NE.8.OR.PROP(GRATE).NE.0)GOTO 2035
+L2034:hit(2034);                                    // 2034    IF(J.NE.8.OR.PROP(GRATE).NE.0)GOTO 2035
+    if (j != 8 || prop(grate) != 0) goto L2035;
     // [62:"ARE YOU TRYING TO GET INTO THE CAVE?" 63:"THE GRATE IS VERY SOLID..." 54:"OK"]
-    yes(62, 63, 54, yea);                           //         CALL YES(62,63,54,YEA)
-L2033:if (yea == 0) goto L2011;                     // 2033    IF(YEA.EQ.0)GOTO 2011
+    yes_ask(62);                                    //         CALL YES(62,63,54,YEA)
+    ADVENT_ACCEPT(12);
+    yes_answer(63, 54, yea);
+L2033:hit(2033);if (yea == 0) goto L2011;           // 2033    IF(YEA.EQ.0)GOTO 2011
     goto L2020;                                     //         GOTO 2020
-L2035:if (iplace[5]!=j && iplace[5]!=-1) goto L2020;// 2035    IF(IPLACE(5).NE.J.AND.IPLACE(5).NE.-1)GOTO 2020
+L2035:hit(2035);                                    // 2035    IF(IPLACE(5).NE.J.AND.IPLACE(5).NE.-1)GOTO 2020
+    if (iplace(5)!=j && iplace(5)!=-1) goto L2020;
     if (jobj != 5) goto L2020;                      //         IF(JOBJ.NE.5)GOTO 2020
     // [22:"MY WORD FOR HITTING SOMETHING WITH THE ROD IS 'STRIKE'."]
     speak(22);                                      //         CALL SPEAK(22)
     goto L2020;                                     //         GOTO 2020
                                                     // 
                                                     // 
-L2036:switch (jverb) {                              // 2036    GOTO(2037,5062,5062,9403,2009,9403,9404,9406,5062,5062,
+L2036:hit(2036);switch (jverb) {                    // 2036    GOTO(2037,5062,5062,9403,2009,9403,9404,9406,5062,5062,
         case  1: goto L2037;                        //       1 5200,5300,5062,5062,5062,5062)JVERB
         case  2: goto L5062;
         case  3: goto L5062;
@@ -1372,62 +3290,64 @@ L2036:switch (jverb) {                              // 2036    GOTO(2037,5062,50
         case 16: goto L5062;
         default: break;
     }
-    pause("OOPS");                                  //         PAUSE 'OOPS'
+    ADVENT_PAUSE(13, "OOPS");                       //         PAUSE 'OOPS'
                                                     // 2037    IF((IOBJ(J).EQ.0).OR.(ICHAIN(IOBJ(J)).NE.0)) GOTO 5062
-L2037:if (iobj.at(j) == 0 || ichain.at(iobj[j]) != 0) goto L5062;
+L2037:hit(2037);if (objects_at_.at(j).size() != 1) goto L5062;
     for (i = 1; i <= 3; ++i) {                      //         DO 5312 I=1,3
         if (dseen[i] != 0) goto L5062;              //         IF(DSEEN(I).NE.0)GOTO 5062
     }                                               // 5312    CONTINUE
-    jobj = iobj[j];                                 //         JOBJ=IOBJ(J)
+    jobj = objects_at_.at(j)[0];                    //         JOBJ=IOBJ(J)
     goto L2027;                                     //         GOTO 2027
-L5062:if (b != scaffolding::a5_space) goto L5333;   // 5062    IF(B.NE.' ')GOTO 5333
+L5062:hit(5062);                                    // 5062    IF(B.NE.' ')GOTO 5333
+    if (b != scaffolding::a5_space) goto L5333;
                                                     //         TYPE 5063,A
                                                     // 5063    FORMAT('  ',A5,' WHAT?',/)
     io.type("  "); io.type(scaffolding::as_string(a)); io.type(" WHAT?\n");
     goto L2020;                                     //         GOTO 2020
                                                     //
-L5333:                                              // 5333    TYPE 5334,A,B
+L5333:hit(5333);                                    // 5333    TYPE 5334,A,B
                                                     // 5334    FORMAT(' ',2A5,' WHAT?',/)
     io.type(" "); io.type(scaffolding::as_string(a)); io.type(scaffolding::as_string(b)); io.type(" WHAT?\n");
     goto L2020;                                     //         GOTO 2020
-L5014:if (idark == 0) goto L8;                      // 5014    IF(IDARK.EQ.0) GOTO 8
+L5014:hit(5014);if (idark == 0) goto L8;            // 5014    IF(IDARK.EQ.0) GOTO 8
                                                     //
-    if (io.ran(5014) > 0.25) goto L8;               //         IF(RAN(QZ).GT.0.25) GOTO 8
+    if (ran(5014) > 0.25) goto L8;                  //         IF(RAN(QZ).GT.0.25) GOTO 8
     // [23:"YOU FELL INTO A PIT AND BROKE EVERY BONE IN YOUR BODY!"]
     speak(23);                                      // 5017    CALL SPEAK(23)
-    pause("GAME IS OVER");                          //         PAUSE 'GAME IS OVER'
+    ADVENT_PAUSE(14, "GAME IS OVER");               //         PAUSE 'GAME IS OVER'
     goto L2011;                                     //         GOTO 2011
     // [Interesting that rather than choosing to STOP Crowther allowed the
     // player to keep going with a deliberate GOTO 2011 on return from PAUSE.]
                                                     // 
                                                     // 
                                                     // 
-L5000:jobj = k;                                     // 5000    JOBJ=K
+L5000:hit(5000);jobj = k;                           // 5000    JOBJ=K
     if (twowds != 0) goto L2028;                    //         IF(TWOWDS.NE.0)GOTO 2028
                                                     //         IF((J.EQ.IPLACE(K)).OR.(IPLACE(K).EQ.-1)) GOTO 5004
-    if (j == iplace.at(k) || iplace[k] == -1) goto L5004;
+    if (j == iplace(k) || iplace(k) == -1) goto L5004;
     if (k != grate) goto L502;                      //         IF(K.NE.GRATE)GOTO 502
     if (j == 1 || j == 4 || j == 7) goto L5098;     //         IF((J.EQ.1).OR.(J.EQ.4).OR.(J.EQ.7))GOTO 5098
     if (j > 9 && j < 15) goto L5097;                //         IF((J.GT.9).AND.(J.LT.15))GOTO 5097
-L502:if (b != scaffolding::a5_space) goto L5316;    // 502     IF(B.NE.' ')GOTO 5316
+L502:hit(502);                                      // 502     IF(B.NE.' ')GOTO 5316
+    if (b != scaffolding::a5_space) goto L5316;
                                                     //         TYPE 5005,A
                                                     // 5005    FORMAT(' I SEE NO ',A5,' HERE.',/)
     io.type(" I SEE NO ");
     io.type(scaffolding::as_string(a));
     io.type(" HERE.\n");
     goto L2011;                                     //         GOTO 2011
-L5316:                                              // 5316    TYPE 5317,A,B
+L5316:hit(5316);                                    // 5316    TYPE 5317,A,B
                                                     // 5317    FORMAT(' I SEE NO ',2A5,' HERE.'/)
     io.type(" I SEE NO ");
     io.type(scaffolding::as_string(a));
     io.type(scaffolding::as_string(b));
     io.type(" HERE.\n");
     goto L2011;                                     //         GOTO 2011
-L5098:k = 49;                                       // 5098    K=49
+L5098:hit(5098);k = 49;                             // 5098    K=49
     goto L5014;                                     //         GOTO 5014
-L5097:k = 50;                                       // 5097    K=50
+L5097:hit(5097);k = 50;                             // 5097    K=50
     goto L5014;                                     //         GOTO 5014
-L5004:jobj = k;                                     // 5004    JOBJ=K
+L5004:hit(5004);jobj = k;                           // 5004    JOBJ=K
     if (jverb != 0) goto L2027;                     //         IF(JVERB.NE.0)GOTO 2027
                                                     // 
                                                     // 
@@ -1438,7 +3358,7 @@ L5004:jobj = k;                                     // 5004    JOBJ=K
     io.type(scaffolding::as_string(a));
     io.type("?\n");
     goto L2020;                                     //         GOTO 2020
-L5314:                                              // 5314    TYPE 5315,A,B
+L5314:hit(5314);                                    // 5314    TYPE 5315,A,B
                                                     // 5315    FORMAT(' WHAT DO YOU WANT TO DO WITH THE ',2A5,'?',/)
     io.type(" WHAT DO YOU WANT TO DO WITH THE ");
     io.type(scaffolding::as_string(a));
@@ -1448,89 +3368,90 @@ L5314:                                              // 5314    TYPE 5315,A,B
                                                     //
                                                     //       C CARRY
                                                     //
-L9000:if (jobj == 18) goto L2009;                   // 9000    IF(JOBJ.EQ.18)GOTO 2009
-    if (iplace.at(jobj) != j) goto L5200;           //         IF(IPLACE(JOBJ).NE.J) GOTO 5200
-    if (ifixed.at(jobj) == 0) goto L9002;           // 9001    IF(IFIXED(JOBJ).EQ.0)GOTO 9002
+L9000:hit(9000);if (jobj == 18) goto L2009;         // 9000    IF(JOBJ.EQ.18)GOTO 2009
+    if (iplace(jobj) != j) goto L5200;              //         IF(IPLACE(JOBJ).NE.J) GOTO 5200
+    if (ifixed(jobj) == 0) goto L9002;              // 9001    IF(IFIXED(JOBJ).EQ.0)GOTO 9002
     speak(25); // [25:"YOU CAN'T BE SERIOUS!"]      //         CALL SPEAK(25)
     goto L2011;                                     //         GOTO 2011
-L9002:if (jobj != bird) goto L9004;                 // 9002    IF(JOBJ.NE.BIRD)GOTO 9004
-    if (iplace[rod] != -1) goto L9003;              //         IF(IPLACE(ROD).NE.-1)GOTO 9003
+L9002:hit(9002);if (jobj != bird) goto L9004;       // 9002    IF(JOBJ.NE.BIRD)GOTO 9004
+    if (iplace(rod) != -1) goto L9003;              //         IF(IPLACE(ROD).NE.-1)GOTO 9003
     // [26:"THE BIRD WAS UNAFRAID WHEN YOU ENTERED, BUT AS YOU APPROACH IT BECOMES DISTURBED AND YOU CANNOT CATCH IT."]
     speak(26);                                      //         CALL SPEAK(26)
     goto L2011;                                     //         GOTO 2011
-L9003:if (iplace[4]==-1 || iplace[4]==j) goto L9004;// 9003    IF((IPLACE(4).EQ.-1).OR.(IPLACE(4).EQ.J)) GOTO 9004
+L9003:hit(9003);                                    // 9003    IF((IPLACE(4).EQ.-1).OR.(IPLACE(4).EQ.J)) GOTO 9004
+    if (iplace(4)==-1 || iplace(4)==j) goto L9004;
     // [27:"YOU CAN CATCH THE BIRD, BUT YOU CANNOT CARRY IT."]
     speak(27);                                      //         CALL SPEAK(27)
     goto L2011;                                     //         GOTO 2011
-L9004:iplace.at(jobj) = -1; // [-1 means holding]   // 9004    IPLACE(JOBJ)=-1
-L9005:if (iobj.at(j) != jobj) goto L9006;           // 9005    IF(IOBJ(J).NE.JOBJ) GOTO 9006
-    iobj.at(j) = ichain.at(jobj);                   //         IOBJ(J)=ICHAIN(JOBJ)
-    goto L2009;                                     //         GOTO 2009
-L9006:itemp = iobj.at(j);                           // 9006    ITEMP=IOBJ(J)
-L9007:if (ichain.at(itemp) == jobj) goto L9008;     // 9007    IF(ICHAIN(ITEMP).EQ.(JOBJ)) GOTO 9008
-    itemp = ichain.at(itemp);                       //         ITEMP=ICHAIN(ITEMP)
-    goto L9007;                                     //         GOTO 9007
-L9008:ichain.at(itemp) = ichain.at(jobj);           // 9008    ICHAIN(ITEMP)=ICHAIN(JOBJ)
+L9004:hit(9004);iplace(jobj) = -1;                  // [-1 means holding]      // 9004    IPLACE(JOBJ)=-1
+L9005:hit(9005);objects_at_.erase(j, jobj);         // 9005    IF(IOBJ(J).NE.JOBJ) GOTO 9006
+    // [If jobj isn't at j, as when a bird that     //         IOBJ(J)=ICHAIN(JOBJ)
+    //  is carried is killed, Crowther's walk       //         GOTO 2009
+    //  of the chain would run off its end;         // 9006    ITEMP=IOBJ(J)
+    //  erase() throws instead.]                    // 9007    IF(ICHAIN(ITEMP).EQ.(JOBJ)) GOTO 9008
+                                                    //         ITEMP=ICHAIN(ITEMP)
+                                                    //         GOTO 9007
+                                                    // 9008    ICHAIN(ITEMP)=ICHAIN(JOBJ)
     goto L2009;                                     //         GOTO 2009
                                                     // 
                                                     // 
                                                     //       C LOCK, UNLOCK, NO OBJECT YET
                                                     //
-L9403:if (j == 8 || j == 9) goto L5105;             // 9403    IF((J.EQ.8).OR.(J.EQ.9))GOTO 5105
+L9403:hit(9403);if (j == 8 || j == 9) goto L5105;   // 9403    IF((J.EQ.8).OR.(J.EQ.9))GOTO 5105
     // [28:"THERE IS NOTHING HERE WITH A LOCK!"]
     speak(28);                                      // 5032    CALL SPEAK(28)
     goto L2011;                                     //         GOTO 2011
-L5105:jobj = grate;                                 // 5105    JOBJ=GRATE
+L5105:hit(5105);jobj = grate;                       // 5105    JOBJ=GRATE
     goto L2027;                                     //         GOTO 2027
                                                     //
                                                     //       C DISCARD OBJECT
                                                     //
-L5066:if (jobj == 18) goto L2009;                   // 5066    IF(JOBJ.EQ.18)GOTO 2009
-    if (iplace.at(jobj) != -1) goto L5200;          //         IF(IPLACE(JOBJ).NE.-1) GOTO 5200
+L5066:hit(5066);if (jobj == 18) goto L2009;         // 5066    IF(JOBJ.EQ.18)GOTO 2009
+    if (iplace(jobj) != -1) goto L5200;             //         IF(IPLACE(JOBJ).NE.-1) GOTO 5200
                                                     // 5012    IF((JOBJ.NE.BIRD).OR.(J.NE.19).OR.(PROP(11).EQ.1))GOTO 9401
-    if (jobj != bird || j != 19 || prop[11] == 1) goto L9401;
+    if (jobj != bird || j != 19 || prop(11) == 1) goto L9401;
     // [30:"THE LITTLE BIRD ATTACKS THE GREEN SNAKE, AND IN AN ASTOUNDING FLURRY DRIVES THE SNAKE AWAY."]
     speak(30);                                      //         CALL SPEAK(30)
-    prop[11] = 1;                                   //         PROP(11)=1
-L5160:ichain.at(jobj) = iobj.at(j);                 // 5160    ICHAIN(JOBJ)=IOBJ(J)
-    iobj.at(j) = jobj;                              //         IOBJ(J)=JOBJ
-    iplace.at(jobj) = j;                            //         IPLACE(JOBJ)=J
+    prop(11) = 1;                                   //         PROP(11)=1
+L5160:hit(5160);objects_at_.push_front(j, jobj);    // 5160    ICHAIN(JOBJ)=IOBJ(J)
+                                                    //         IOBJ(J)=JOBJ
+    iplace(jobj) = j;                               //         IPLACE(JOBJ)=J
     goto L2011;                                     //         GOTO 2011
                                                     //
-L9401:speak(54); // [54:"OK"]                       // 9401    CALL SPEAK(54)
+L9401:hit(9401);speak(54);                          // [54:"OK"]                       // 9401    CALL SPEAK(54)
     goto L5160;                                     //         GOTO 5160
                                                     //
                                                     //       C LOCK,UNLOCK OBJECT
                                                     //
                                                     // 5031    IF(IPLACE(KEYS).NE.-1.AND.IPLACE(KEYS).NE.J)GOTO 5200
-L5031:if (iplace[keys] != -1 && iplace[keys] != j) goto L5200;
+L5031:hit(5031);if (iplace(keys) != -1 && iplace(keys) != j) goto L5200;
     if (jobj != 4) goto L5102;                      //         IF(JOBJ.NE.4)GOTO 5102
     speak(32); // [32:"IT HAS NO LOCK."]            //         CALL SPEAK(32)
     goto L2011;                                     //         GOTO 2011
-L5102:if (jobj != keys) goto L5104;                 // 5102    IF(JOBJ.NE.KEYS)GOTO 5104
+L5102:hit(5102);if (jobj != keys) goto L5104;       // 5102    IF(JOBJ.NE.KEYS)GOTO 5104
     speak(55); // [55:"YOU CAN'T UNLOCK THE KEYS."] //         CALL SPEAK(55)
     goto L2011;                                     //         GOTO 2011
-L5104:if (jobj == grate) goto L5107;                // 5104    IF(JOBJ.EQ.GRATE)GOTO 5107
+L5104:hit(5104);if (jobj == grate) goto L5107;      // 5104    IF(JOBJ.EQ.GRATE)GOTO 5107
     // [33:"I DON'T KNOW HOW TO LOCK OR UNLOCK SUCH A THING."]
     speak(33);                                      //         CALL SPEAK(33)
     goto L2011;                                     //         GOTO 2011
-L5107:if (jverb == 4) goto L5033;                   // 5107    IF(JVERB.EQ.4) GOTO 5033
-    if (prop[grate] != 0) goto L5034;               //         IF(PROP(GRATE).NE.0)GOTO 5034
+L5107:hit(5107);if (jverb == 4) goto L5033;         // 5107    IF(JVERB.EQ.4) GOTO 5033
+    if (prop(grate) != 0) goto L5034;               //         IF(PROP(GRATE).NE.0)GOTO 5034
     // [34:"THE GRATE WAS ALREADY LOCKED."]
     speak(34);                                      //         CALL SPEAK(34)
     goto L2011;                                     //         GOTO 2011
-L5034:speak(35); // [35:"THE GRATE IS NOW LOCKED."] // 5034    CALL SPEAK(35)
-    prop[grate] = 0; // [0 means locked!]           //         PROP(GRATE)=0
-    prop[8] = 0;                                    //         PROP(8)=0
+L5034:hit(5034);speak(35);                          // [35:"THE GRATE IS NOW LOCKED."] // 5034    CALL SPEAK(35)
+    prop(grate) = 0; // [0 means locked!]           //         PROP(GRATE)=0
+    prop(8) = 0;                                    //         PROP(8)=0
     goto L2011;                                     //         GOTO 2011
-L5033:if (prop[grate] == 0) goto L5109;             // 5033    IF(PROP(GRATE).EQ.0)GOTO 5109
+L5033:hit(5033);if (prop(grate) == 0) goto L5109;   // 5033    IF(PROP(GRATE).EQ.0)GOTO 5109
     // [36:"THE GRATE WAS ALREADY UNLOCKED."]
     speak(36);                                      //         CALL SPEAK(36)
     goto L2011;                                     //         GOTO 2011
     // [37:"THE GRATE IS NOW UNLOCKED."]
-L5109:speak(37);                                    // 5109    CALL SPEAK(37)
-    prop[grate] = 1; // [1 means unlocked]          //         PROP(GRATE)=1
-    prop[8] = 1;                                    //         PROP(8)=1
+L5109:hit(5109);speak(37);                          // 5109    CALL SPEAK(37)
+    prop(grate) = 1; // [1 means unlocked]          //         PROP(GRATE)=1
+    prop(8) = 1;                                    //         PROP(8)=1
     goto L2011;                                     //         GOTO 2011
                                                     // 
                                                     // 
@@ -1538,8 +3459,8 @@ L5109:speak(37);                                    // 5109    CALL SPEAK(37)
                                                     //       C LIGHT LAMP
                                                     //
                                                     // 9404    IF((IPLACE(2).NE.J).AND.(IPLACE(2).NE.-1))GOTO 5200
-L9404:if (iplace[2] != j && iplace[2] != -1) goto L5200;
-    prop[2] = 1;                                    //         PROP(2)=1
+L9404:hit(9404);if (iplace(2) != j && iplace(2) != -1) goto L5200;
+    prop(2) = 1;                                    //         PROP(2)=1
     idark = 0;                                      //         IDARK=0
     speak(39); // [39:"YOUR LAMP IS NOW ON."]       //         CALL SPEAK(39)
     goto L2011;                                     //         GOTO 2011
@@ -1547,21 +3468,21 @@ L9404:if (iplace[2] != j && iplace[2] != -1) goto L5200;
                                                     //       C LAMP OFF
                                                     //
                                                     // 9406    IF((IPLACE(2).NE.J).AND.(IPLACE(2).NE.-1)) GOTO 5200
-L9406:if (iplace[2] != j && iplace[2] != -1) goto L5200;
-    prop[2] = 0;                                    //         PROP(2)=0
+L9406:hit(9406);if (iplace(2) != j && iplace(2) != -1) goto L5200;
+    prop(2) = 0;                                    //         PROP(2)=0
     speak(40); // [40:"YOUR LAMP IS NOW OFF."]      //         CALL SPEAK(40)
     goto L2011;                                     //         GOTO 2011
                                                     //
                                                     //       C STRIKE
                                                     //
-L5081:if (jobj != 12) goto L5200;                   // 5081    IF(JOBJ.NE.12)GOTO 5200
+L5081:hit(5081);if (jobj != 12) goto L5200;         // 5081    IF(JOBJ.NE.12)GOTO 5200
     // [Strike the fissure (object 12) with the rod and a crystal bridge apears!]
-    prop[12] = 1;                                   //         PROP(12)=1
+    prop(12) = 1;                                   //         PROP(12)=1
     goto L2003;                                     //         GOTO 2003
                                                     //
                                                     //       C ATTACK
                                                     //
-L5300:for (id = 1; id <= 3; ++id) {                 // 5300    DO 5313 ID=1,3
+L5300:hit(5300);for (id = 1; id <= 3; ++id) {       // 5300    DO 5313 ID=1,3
         iid = id;                                   //         IID=ID
         if (dseen[id] != 0) goto L5307;             //         IF(DSEEN(ID).NE.0)GOTO 5307
     }                                               // 5313    CONTINUE
@@ -1572,27 +3493,27 @@ L5300:for (id = 1; id <= 3; ++id) {                 // 5300    DO 5313 ID=1,3
     speak(44);                                      //         CALL SPEAK(44)
     goto L2011;                                     //         GOTO 2011
     // [45:"THE LITTLE BIRD IS NOW DEAD. ITS BODY DISAPPEARS."]
-L5302:speak(45);                                    // 5302    CALL SPEAK(45)
-    iplace.at(jobj) = 300;                          //         IPLACE(JOBJ)=300
+L5302:hit(5302);speak(45);                          // 5302    CALL SPEAK(45)
+    iplace(jobj) = 300;                             //         IPLACE(JOBJ)=300
     goto L9005;                                     //         GOTO 9005
                                                     //
-L5307:if (io.ran(5307) > 0.4) goto L5309;           // 5307    IF(RAN(QZ).GT.0.4) GOTO 5309
+L5307:hit(5307);if (ran(5307) > 0.4) goto L5309;    // 5307    IF(RAN(QZ).GT.0.4) GOTO 5309
     dseen.at(iid) = 0;                              //         DSEEN(IID)=0
     odloc.at(iid) = 0;                              //         ODLOC(IID)=0
     dloc.at(iid) = 0;                               //         DLOC(IID)=0
     speak(47); // [47:"YOU KILLED A LITTLE DWARF."] //         CALL SPEAK(47)
     goto L5311;                                     //         GOTO 5311
     // [48:"YOU ATTACK A LITTLE DWARF, BUT HE DODGES OUT OF THE WAY."]
-L5309:speak(48);                                    // 5309    CALL SPEAK(48)
-L5311:k = 21;                                       // 5311    K=21
+L5309:hit(5309);speak(48);                          // 5309    CALL SPEAK(48)
+L5311:hit(5311);k = 21;                             // 5311    K=21
     goto L5014;                                     //         GOTO 5014
                                                     //
                                                     //       C EAT
                                                     //
                                                     // 5502    IF((IPLACE(FOOD).NE.J.AND.IPLACE(FOOD).NE.-1).OR.PROP(FOOD).NE.0
                                                     //       1 .OR.JOBJ.NE.FOOD)GOTO 5200
-L5502:if ((iplace[food] != j && iplace[food] != -1) || prop[food] != 0 || jobj != food) goto L5200;
-    prop[food] = 1;                                 //         PROP(FOOD)=1
+L5502:hit(5502);if ((iplace(food) != j && iplace(food) != -1) || prop(food) != 0 || jobj != food) goto L5200;
+    prop(food) = 1;                                 //         PROP(FOOD)=1
     jspk = 72; // [72:"EATEN!"]                     // 5501    JSPK=72
     goto L5200;                                     //         GOTO 5200
                                                     //
@@ -1600,8 +3521,8 @@ L5502:if ((iplace[food] != j && iplace[food] != -1) || prop[food] != 0 || jobj !
                                                     //
                                                     // 5504    IF((IPLACE(WATER).NE.J.AND.IPLACE(WATER).NE.-1)
                                                     //       1 .OR.PROP(WATER).NE.0.OR.JOBJ.NE.WATER) GOTO 5200
-L5504:if ((iplace[water] != j && iplace[water] != -1) || prop[water] != 0 || jobj != water) goto L5200;
-    prop[water] = 1;                                //         PROP(WATER)=1
+L5504:hit(5504);if ((iplace(water) != j && iplace(water) != -1) || prop(water) != 0 || jobj != water) goto L5200;
+    prop(water) = 1;                                //         PROP(WATER)=1
     // [74:"THE BOTTLE OF WATER IS NOW EMPTY."]
     jspk = 74;                                      //         JSPK=74
     goto L5200;                                     //         GOTO 5200
@@ -1609,36 +3530,2542 @@ L5504:if ((iplace[water] != j && iplace[water] != -1) || prop[water] != 0 || job
                                                     //       C RUB
                                                     //
     // [76:"PECULIAR.  NOTHING UNEXPECTED HAPPENS."]
-L5505:if (jobj != lamp) jspk = 76;                  // 5505    IF(JOBJ.NE.LAMP)JSPK=76
+L5505:hit(5505);if (jobj != lamp) jspk = 76;        // 5505    IF(JOBJ.NE.LAMP)JSPK=76
     goto L5200;                                     //         GOTO 5200
                                                     //
                                                     //       C POUR
                                                     //
     // [78:"YOU CAN'T POUR THAT."]
-L5506:if (jobj != water) jspk = 78;                 // 5506    IF(JOBJ.NE.WATER)JSPK=78
-    prop[water] = 1;                                //         PROP(WATER)=1
+L5506:hit(5506);if (jobj != water) jspk = 78;       // 5506    IF(JOBJ.NE.WATER)JSPK=78
+    prop(water) = 1;                                //         PROP(WATER)=1
     goto L5200;                                     //         GOTO 5200
                                                     // 
                                                     // 
-                                                    // 
+                                                    //
 }                                                   //         END
 
 
+#undef ADVENT_PAUSE
+#undef ADVENT_ACCEPT
+
+
+// Play the game, getting each line of input from io.getline(), until the
+// user terminates it at a PAUSE.
+void adventure(
+    shared_world w,                 // tables loaded from the Adventure data file
+    scaffolding::advent_io & io,    // communication with outside world
+    session_options options = {})
+{
+    session s(std::move(w), options);
+    auto status = s.start(io);
+    while (status != session_status::terminated)
+        status = s.step(io.getline(), io);
+}
+
+
+// [Not part of Crowther's code. A line of input for a game, and the game's
+//  response to it; see step_many().]
+struct session_command {
+    session * game;
+    std::string_view input_line;
+};
+
+struct session_reply {
+    std::string output;
+    session_status status = session_status::awaiting_input;
+};
+
+
+// [Not part of Crowther's code. Give each game in commands its line of
+//  input, as session::step() would, and put the game's output and status in
+//  the reply at the same index. The replies are resized to match; their
+//  buffers are reused, so a caller stepping a batch per tick allocates
+//  little once the buffers have grown. The games are stepped grouped by the
+//  tables they are played with, so each world's tables are brought into
+//  cache once per batch rather than once per game. A game given more than
+//  one line in a batch is given them in order. An exception thrown by a
+//  step ends the batch; the steps already taken stand, and the replies to
+//  the steps not taken are empty, with the status awaiting_input.]
+void step_many(const std::vector<session_command> & commands, std::vector<session_reply> & replies)
+{
+    class advent_io_reply final : public scaffolding::advent_io {
+    public:
+        std::string * output = nullptr;
+
+        std::string getline() override
+        {
+            throw scaffolding::adventure_exception("step_many: no input");
+        }
+
+        void type(const std::string & msg) override { *output += msg; }
+        void type(std::string_view msg) override { *output += msg; }
+        void type(int n) override { *output += std::to_string(n); }
+    };
+
+    replies.resize(commands.size());
+    for (auto & reply : replies) {
+        reply.output.clear();
+        reply.status = session_status::awaiting_input;
+    }
+
+    // (in the usual case every game is played with the same tables, so
+    //  there is nothing to sort)
+    std::vector<uint_least32_t> order(commands.size());
+    for (size_t n = 0; n < order.size(); ++n)
+        order[n] = static_cast<uint_least32_t>(n);
+    const auto tables = [&](uint_least32_t n) { return commands[n].game->tables().get(); };
+    const bool mixed = std::any_of(order.begin(), order.end(), [&](uint_least32_t n) {
+        return tables(n) != tables(0);
+    });
+    if (mixed) {
+        std::stable_sort(order.begin(), order.end(), [&](uint_least32_t x, uint_least32_t y) {
+            return std::less<const world *>()(tables(x), tables(y));
+        });
+    }
+
+    advent_io_reply io;
+    for (const uint_least32_t n : order) {
+        io.output = &replies[n].output;
+        replies[n].status = commands[n].game->step(commands[n].input_line, io);
+    }
+}
+
+// [Not part of Crowther's code. As above, returning the replies.]
+std::vector<session_reply> step_many(const std::vector<session_command> & commands)
+{
+    std::vector<session_reply> replies;
+    step_many(commands, replies);
+    return replies;
+}
+
+
+// [Not part of Crowther's code. The coroutine returned by play(). It starts
+//  at once and runs until the game first waits for input. It owns its
+//  coroutine frame; done() is true once the game has ended, either because
+//  the user typed X at a PAUSE or because of an error, in which case
+//  rethrow_if_failed() rethrows the exception.]
+class adventure_task {
+public:
+    struct promise_type {
+        std::exception_ptr failure;
+
+        adventure_task get_return_object()
+        {
+            return adventure_task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { failure = std::current_exception(); }
+    };
+
+    adventure_task(adventure_task && other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+    adventure_task & operator=(adventure_task && other) noexcept
+    {
+        if (this != &other) {
+            if (h_)
+                h_.destroy();
+            h_ = std::exchange(other.h_, nullptr);
+        }
+        return *this;
+    }
+    ~adventure_task()
+    {
+        if (h_)
+            h_.destroy();
+    }
+
+    bool done() const { return !h_ || h_.done(); }
 
+    void rethrow_if_failed() const
+    {
+        if (h_ && h_.promise().failure)
+            std::rethrow_exception(h_.promise().failure);
+    }
+
+private:
+    explicit adventure_task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
 
 
-/*
-       ###    ########  ##     ## ########     ###    ######## 
-      ## ##   ##     ## ##     ## ##     ##   ## ##      ##    
-     ##   ##  ##     ## ##     ## ##     ##  ##   ##     ##    
-    ##     ## ##     ## ##     ## ##     ## ##     ##    ##    
-    ######### ##     ##  ##   ##  ##     ## #########    ##    
-    ##     ## ##     ##   ## ##   ##     ## ##     ##    ##    
-    ##     ## ########     ###    ########  ##     ##    ##    
-*/
+// [Not part of Crowther's code. Play the game as a coroutine, awaiting each
+//  line of input from io, so that any number of games may wait for input on
+//  one thread. Crowther's logic runs unchanged, in a session.]
+adventure_task play(
+    shared_world w,                     // tables loaded from the Adventure data file
+    scaffolding::advent_io_async & io,  // communication with outside world
+    session_options options = {})
+{
+    session s(std::move(w), options);
+    auto status = s.start(io);
+    while (status != session_status::terminated)
+        status = s.step(co_await io.next_line(), io);
+}
+
+
+// [Not part of Crowther's code. Plays many games at once on a pool of worker
+//  threads, all sharing one world. Each worker has its own run queue of games
+//  with input to process, and an idle worker steals from the others. A game
+//  is queued as soon as input is posted for it, and is only ever run by one
+//  worker at a time. Output from each step goes to the given handler, on the
+//  worker's thread; the handler may post more input. A game waiting for
+//  input may be evicted: it is saved as a snapshot and its session freed,
+//  and it is restored when next given input.]
+class session_scheduler {
+public:
+    using session_id = size_t;
+    using output_handler = std::function<void(session_id, std::string_view output, session_status)>;
+
+    session_scheduler(shared_world w, output_handler on_output, unsigned workers = 0)
+    : world_(std::move(w)), on_output_(std::move(on_output))
+    {
+        if (workers == 0)
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned n = 0; n < workers; ++n)
+            queues_.push_back(std::make_unique<run_queue>());
+        for (unsigned n = 0; n < workers; ++n)
+            threads_.emplace_back([this, n] { work(n); });
+    }
+
+    ~session_scheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto & thread : threads_)
+            thread.join();
+    }
+
+    // start a new game; its opening output goes to the handler
+    session_id open(session_options options = {})
+    {
+        game * g = nullptr;
+        session_id id;
+        {
+            std::lock_guard<std::mutex> lock(games_mutex_);
+            if (free_.empty()) {
+                id = games_.size();
+                games_.push_back(nullptr);
+            }
+            else {
+                id = free_.back();
+                free_.pop_back();
+            }
+            games_[id] = std::make_unique<game>(id, world_, options);
+            g = games_[id].get();
+        }
+        g->scheduled = true;
+        schedule(g);
+        return id;
+    }
+
+    // give the given game its next line of input
+    void post(session_id id, std::string line)
+    {
+        game * g = find(id);
+        if (!g)
+            return;
+        bool need_scheduling = false;
+        {
+            std::lock_guard<std::mutex> lock(g->mutex);
+            g->input.push_back(std::move(line));
+            need_scheduling = !g->scheduled;
+            g->scheduled = true;
+        }
+        if (need_scheduling)
+            schedule(g);
+    }
+
+    // save the given game as a snapshot and free its session, if it is
+    // waiting for input; return true if it was evicted
+    bool evict(session_id id)
+    {
+        game * g = find(id);
+        if (!g)
+            return false;
+        std::lock_guard<std::mutex> lock(g->mutex);
+        if (g->scheduled || !g->s)
+            return false;
+        g->snapshot = std::make_unique<session_snapshot>(g->s->save());
+        g->s.reset();
+        return true;
+    }
+
+    // end the given game, dropping any input not yet processed; its id may
+    // be reused once any step in progress is done
+    void close(session_id id)
+    {
+        game * g = find(id);
+        if (!g)
+            return;
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(g->mutex);
+            g->closed = true;
+            g->input.clear();
+            idle = !g->scheduled;
+            g->scheduled = true; // (so that no worker runs it again)
+        }
+        if (idle)
+            release(id);
+    }
+
+    // wait until no game has input left to process
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_.wait(lock, [this] { return active_ == 0; });
+    }
+
+    unsigned workers() const { return static_cast<unsigned>(threads_.size()); }
+
+private:
+    struct game {
+        game(session_id id, const shared_world & w, session_options options)
+        : id(id), options(options) { s.emplace(w, options); }
+        const session_id id;
+        const session_options options;
+        std::optional<session> s;           // [none while evicted]
+        std::unique_ptr<session_snapshot> snapshot; // [the game while evicted]
+        std::mutex mutex;                   // [guards input, scheduled, closed, s and snapshot]
+        std::deque<std::string> input;
+        bool scheduled = false;             // [queued or running]
+        bool closed = false;
+        bool started = false;
+        bool failed = false;                // [a step threw; used only by the worker running it]
+        std::string output;
+    };
+
+    game * find(session_id id)
+    {
+        std::lock_guard<std::mutex> lock(games_mutex_);
+        return games_.at(id).get();
+    }
+
+    void release(session_id id)
+    {
+        std::lock_guard<std::mutex> lock(games_mutex_);
+        games_.at(id).reset();
+        free_.push_back(id);
+    }
+
+    struct run_queue {
+        std::mutex mutex;
+        std::deque<game *> games;
+    };
+
+    // queue the given game on this worker's queue, or any queue if not on a worker
+    void schedule(game * g)
+    {
+        const size_t n = current_worker_ < queues_.size() && current_scheduler_ == this
+            ? current_worker_ : next_queue_++ % queues_.size();
+        // (counted before it is queued, so a worker can't finish it first)
+        ++active_;
+        ++queued_;
+        {
+            std::lock_guard<std::mutex> lock(queues_[n]->mutex);
+            queues_[n]->games.push_back(g);
+        }
+        if (sleeping_ > 0) {
+            // (taking the lock means a worker about to sleep will see queued_)
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            wake_.notify_one();
+        }
+    }
+
+    // take a game from the front of our own queue, else from the back of another's
+    game * take(size_t n)
+    {
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            run_queue & q = *queues_[(n + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.games.empty()) {
+                game * g;
+                if (i == 0) {
+                    g = q.games.front();
+                    q.games.pop_front();
+                }
+                else {
+                    g = q.games.back();
+                    q.games.pop_back();
+                }
+                return g;
+            }
+        }
+        return nullptr;
+    }
+
+    void work(size_t n)
+    {
+        current_worker_ = n;
+        current_scheduler_ = this;
+        for (;;) {
+            game * g = take(n);
+            if (!g) {
+                std::unique_lock<std::mutex> lock(idle_mutex_);
+                ++sleeping_;
+                wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+                --sleeping_;
+                if (stopping_)
+                    return;
+                continue;
+            }
+            --queued_;
+            run(*g);
+            if (--active_ == 0) {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                idle_.notify_all();
+            }
+        }
+    }
+
+    // process all the input the given game has; requeue it if more arrives.
+    // If restoring, starting or stepping the game throws, the handler is
+    // given the output so far with the status failed, and the game's
+    // session is freed; any more input it is given is dropped.
+    void run(game & g)
+    {
+        if (!g.failed) {
+            try {
+                if (play(g))
+                    return;
+            }
+            catch (const std::exception &) {
+                {
+                    std::lock_guard<std::mutex> lock(g.mutex);
+                    g.failed = true;
+                    g.s.reset();
+                    g.snapshot.reset();
+                }
+                on_output_(g.id, g.output, session_status::failed);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(g.mutex);
+            g.input.clear();
+            if (!g.closed) {
+                g.scheduled = false;
+                return;
+            }
+        }
+        release(g.id); // (closed while it was running)
+    }
+
+    // play the given game until it has no input; return false if it was closed
+    bool play(game & g)
+    {
+        scaffolding::advent_io_string io(g.output);
+        g.output.clear();
+        if (!g.s) {
+            // (a game evicted while waiting for input is restored as it was)
+            std::lock_guard<std::mutex> lock(g.mutex);
+            g.s.emplace(world_, g.options);
+            g.s->restore(*g.snapshot);
+            g.snapshot.reset();
+        }
+        if (!g.started) {
+            g.started = true;
+            const auto status = g.s->start(io);
+            on_output_(g.id, g.output, status);
+        }
+        for (;;) {
+            std::string line;
+            {
+                std::lock_guard<std::mutex> lock(g.mutex);
+                if (g.input.empty() && g.closed)
+                    return false;
+                if (g.input.empty()) {
+                    g.scheduled = false;
+                    return true;
+                }
+                line = std::move(g.input.front());
+                g.input.pop_front();
+            }
+            g.output.clear();
+            const auto status = g.s->step(line, io);
+            on_output_(g.id, g.output, status);
+        }
+    }
+
+    shared_world world_;
+    output_handler on_output_;
+    std::mutex games_mutex_;                // [guards games_]
+    std::deque<std::unique_ptr<game>> games_; // [null for a closed game]
+    std::vector<session_id> free_;          // [ids of closed games, for reuse]
+    std::vector<std::unique_ptr<run_queue>> queues_;
+    std::atomic<size_t> next_queue_{0};
+    std::mutex idle_mutex_;                 // [guards sleeping_ and stopping_]
+    std::condition_variable wake_, idle_;
+    std::atomic<size_t> queued_{0};         // [games waiting in run queues]
+    std::atomic<size_t> active_{0};         // [games queued or running]
+    std::atomic<unsigned> sleeping_{0};     // [workers waiting for work]
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    static thread_local size_t current_worker_;
+    static thread_local const session_scheduler * current_scheduler_;
+};
+
+thread_local size_t session_scheduler::current_worker_ = SIZE_MAX;
+thread_local const session_scheduler * session_scheduler::current_scheduler_ = nullptr;
+
+
+#if ADVENT_HAVE_EPOLL
+
+// [Not part of Crowther's code. Settings for a session_server.]
+struct server_options {
+    uint_least16_t port = 0;        // [TCP port to listen on; 0: any free port]
+    unsigned workers = 0;           // [threads playing games; 0: one per core]
+    std::chrono::milliseconds evict_after{std::chrono::minutes(5)}; // [idle time before a game is saved as a snapshot]
+    size_t max_line = 1024;         // [input lines longer than this are cut short]
+    size_t max_output = 64 * 1024;  // [don't read from a connection with this much output unsent...]
+    unsigned max_pending = 8;       // [...or with this many lines not yet responded to]
+};
+
+
+// [Not part of Crowther's code. A line-oriented TCP front end to a
+//  session_scheduler: each connection plays one game. A line of input ends
+//  at a newline; a carriage return before it, NULs and telnet commands are
+//  dropped. The output of each step is sent in one write. The thread calling
+//  run() does all the network I/O, with epoll; the workers only play games,
+//  and hand their output back through an eventfd. A connection with too much
+//  output unsent or too many lines not yet played is not read from until it
+//  catches up, so a client that sends without reading fills its own socket
+//  buffers rather than the server's memory. A game that has had no input for
+//  evict_after is evicted to a snapshot, and restored when it next has input.
+//  The connection is closed when its game ends, or when a step of it throws,
+//  or when the client has shut down its side and has been sent the replies
+//  to every line it sent.]
+class session_server {
+public:
+    explicit session_server(shared_world w, server_options options = {})
+    : options_(options), seeds_(std::random_device{}())
+    {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        const int on = 1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(options.port);
+        socklen_t size = sizeof(addr);
+        if (listen_fd_ < 0 || event_fd_ < 0 || epoll_fd_ < 0
+            || ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+            || ::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0
+            || ::listen(listen_fd_, SOMAXCONN) != 0
+            || ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &size) != 0
+            || !watch(listen_fd_, EPOLLIN, EPOLL_CTL_ADD)
+            || !watch(event_fd_, EPOLLIN, EPOLL_CTL_ADD)) {
+            close_fds();
+            throw scaffolding::adventure_exception("session_server: cannot listen");
+        }
+        port_ = ntohs(addr.sin_port);
+
+        scheduler_ = std::make_unique<session_scheduler>(std::move(w),
+            [this](session_scheduler::session_id id, std::string_view output, session_status status) {
+                on_output(id, output, status);
+            }, options.workers);
+    }
+
+    ~session_server()
+    {
+        scheduler_.reset(); // (so no worker hands over output once the fds are closed)
+        for (const auto & entry : connections_)
+            ::close(entry.first);
+        for (const int fd : dropped_)
+            ::close(fd);
+        close_fds();
+    }
+
+    session_server(const session_server &) = delete;
+    session_server & operator=(const session_server &) = delete;
+
+    // the port the server is listening on
+    uint_least16_t port() const { return port_; }
+
+    // serve connections until stop() is called
+    void run()
+    {
+        using namespace std::chrono_literals;
+        const auto check_every = std::clamp<std::chrono::milliseconds>(options_.evict_after, 10ms, 1000ms);
+        auto next_check = std::chrono::steady_clock::now() + check_every;
+        epoll_event events[64];
+        while (!stopping_) {
+            const int n = ::epoll_wait(epoll_fd_, events, 64, static_cast<int>(check_every.count()));
+            for (int i = 0; i < n; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == listen_fd_)
+                    accept_all();
+                else if (fd == event_fd_)
+                    take_output();
+                else if (auto c = connections_.find(fd); c != connections_.end()) {
+                    if (events[i].events & (EPOLLERR | EPOLLHUP))
+                        drop(*c->second);
+                    else if (events[i].events & EPOLLIN)
+                        read_input(*c->second);
+                    else if (events[i].events & EPOLLOUT)
+                        send_output(*c->second);
+                }
+            }
+            // (only now, so no fd dropped in this batch is reused by an
+            // accept while events for it are still to be handled)
+            for (const int fd : dropped_)
+                ::close(fd);
+            dropped_.clear();
+            if (const auto now = std::chrono::steady_clock::now(); now >= next_check) {
+                evict_idle(now);
+                next_check = now + check_every;
+            }
+        }
+    }
+
+    // make run() return; may be called from any thread
+    void stop()
+    {
+        stopping_ = true;
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto written = ::write(event_fd_, &one, sizeof(one));
+    }
+
+private:
+    using session_id = session_scheduler::session_id;
+
+    // a connection, used only on the thread calling run()
+    struct connection {
+        int fd;
+        session_id id;
+        std::string input;          // [received, not yet a whole line]
+        std::string output;         // [to be sent, from output[sent] on]
+        size_t sent = 0;
+        unsigned pending = 1;       // [lines posted, not yet responded to; 1 for the start]
+        int telnet = 0;             // [0: data; 1: after IAC; 2: after IAC WILL/WONT/DO/DONT]
+        uint32_t events = EPOLLIN;  // [the epoll events asked for]
+        bool finished = false;      // [the game is over; close once output is sent]
+        bool hung_up = false;       // [the client sent EOF; close once all lines are responded to]
+        bool evicted = false;
+        std::chrono::steady_clock::time_point last_input = std::chrono::steady_clock::now();
+    };
+
+    // output handed from the workers to the thread calling run()
+    struct reply {
+        std::string output;
+        unsigned responses = 0;
+        bool finished = false;
+        bool ready = false;          // [listed in ready_]
+    };
+
+    bool watch(int fd, uint32_t events, int op)
+    {
+        epoll_event e{};
+        e.events = events;
+        e.data.fd = fd;
+        return ::epoll_ctl(epoll_fd_, op, fd, &e) == 0;
+    }
+
+    void close_fds()
+    {
+        for (int fd : {listen_fd_, event_fd_, epoll_fd_}) {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+
+    // on a worker thread
+    void on_output(session_id id, std::string_view output, session_status status)
+    {
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto r = replies_.find(id);
+            if (r == replies_.end())
+                return; // (the connection was closed)
+            r->second.output += output;
+            ++r->second.responses;
+            r->second.finished |= status != session_status::awaiting_input;
+            if (!r->second.ready) {
+                r->second.ready = true;
+                wake = ready_.empty();
+                ready_.push_back(id);
+            }
+        }
+        if (wake) {
+            const uint64_t one = 1;
+            [[maybe_unused]] const auto written = ::write(event_fd_, &one, sizeof(one));
+        }
+    }
+
+    void accept_all()
+    {
+        for (;;) {
+            const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            const int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            if (!watch(fd, EPOLLIN, EPOLL_CTL_ADD)) {
+                ::close(fd);
+                continue;
+            }
+            auto c = std::make_unique<connection>();
+            c->fd = fd;
+            session_options options;
+            options.seed = seeds_();
+            {
+                // (held until the reply is listed, so the opening output isn't missed)
+                std::lock_guard<std::mutex> lock(mutex_);
+                c->id = scheduler_->open(options);
+                replies_[c->id] = reply{};
+            }
+            by_id_[c->id] = c.get();
+            connections_[fd] = std::move(c);
+        }
+    }
+
+    void take_output()
+    {
+        uint64_t count;
+        [[maybe_unused]] const auto got = ::read(event_fd_, &count, sizeof(count));
+        std::vector<std::pair<session_id, reply>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const session_id id : ready_) {
+                auto & r = replies_.at(id);
+                ready.emplace_back(id, std::move(r));
+                r = reply{};
+            }
+            ready_.clear();
+        }
+        for (auto & [id, r] : ready) {
+            auto c = by_id_.find(id);
+            if (c == by_id_.end())
+                continue;
+            connection & conn = *c->second;
+            conn.output += r.output;
+            conn.pending -= std::min(conn.pending, r.responses);
+            conn.finished |= r.finished;
+            send_output(conn);
+        }
+    }
+
+    void read_input(connection & c)
+    {
+        char buf[4096];
+        while (wants_input(c)) {
+            const ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+            if (n == 0) {
+                c.hung_up = true;
+                send_output(c);
+                return;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                drop(c);
+                return;
+            }
+            if (n < 0)
+                break;
+            for (ssize_t i = 0; i < n; ++i)
+                take_char(c, static_cast<unsigned char>(buf[i]));
+        }
+        update_events(c);
+    }
+
+    void take_char(connection & c, unsigned char ch)
+    {
+        constexpr unsigned char iac = 255, will = 251, dont = 254;
+        if (c.telnet == 1) {
+            c.telnet = ch >= will && ch <= dont ? 2 : 0;
+            if (ch != iac)
+                return;
+        }
+        else if (c.telnet == 2) {
+            c.telnet = 0;
+            return;
+        }
+        else if (ch == iac) {
+            c.telnet = 1;
+            return;
+        }
+        if (ch == '\n') {
+            if (!c.input.empty() && c.input.back() == '\r')
+                c.input.pop_back();
+            scheduler_->post(c.id, std::move(c.input));
+            c.input.clear();
+            ++c.pending;
+            c.evicted = false;
+            c.last_input = std::chrono::steady_clock::now();
+        }
+        else if (ch != '\0' && c.input.size() < options_.max_line)
+            c.input += static_cast<char>(ch);
+    }
+
+    void send_output(connection & c)
+    {
+        while (c.sent < c.output.size()) {
+            const ssize_t n = ::send(c.fd, c.output.data() + c.sent, c.output.size() - c.sent, MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n < 0 && errno != EINTR) {
+                drop(c);
+                return;
+            }
+            if (n > 0)
+                c.sent += static_cast<size_t>(n);
+        }
+        if (c.sent == c.output.size()) {
+            c.output.clear();
+            c.sent = 0;
+            if (c.finished || (c.hung_up && c.pending == 0)) {
+                drop(c);
+                return;
+            }
+        }
+        update_events(c);
+    }
+
+    bool wants_input(const connection & c) const
+    {
+        return !c.finished && !c.hung_up && c.pending < options_.max_pending
+            && c.output.size() - c.sent < options_.max_output;
+    }
+
+    void update_events(connection & c)
+    {
+        const uint32_t events = (wants_input(c) ? EPOLLIN : 0u) | (c.sent < c.output.size() ? EPOLLOUT : 0u);
+        if (events != c.events && watch(c.fd, events, EPOLL_CTL_MOD))
+            c.events = events;
+    }
+
+    void evict_idle(std::chrono::steady_clock::time_point now)
+    {
+        for (auto & [fd, c] : connections_) {
+            if (!c->evicted && c->pending == 0 && now - c->last_input >= options_.evict_after)
+                c->evicted = scheduler_->evict(c->id);
+        }
+    }
+
+    // end the connection's game and stop watching it; its fd is closed by
+    // run() once the events of the current batch have been handled
+    void drop(connection & c)
+    {
+        const session_id id = c.id;
+        const int fd = c.fd;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            replies_.erase(id);
+            std::erase(ready_, id);
+        }
+        scheduler_->close(id);
+        by_id_.erase(id);
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        dropped_.push_back(fd);
+        connections_.erase(fd); // (c is destroyed)
+    }
+
+    const server_options options_;
+    std::mt19937_64 seeds_;                 // [a seed for each game]
+    int listen_fd_ = -1, event_fd_ = -1, epoll_fd_ = -1;
+    uint_least16_t port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::unordered_map<int, std::unique_ptr<connection>> connections_; // [by fd]
+    std::unordered_map<session_id, connection *> by_id_;
+    std::vector<int> dropped_;              // [fds of connections dropped, to be closed]
+    std::mutex mutex_;                      // [guards replies_ and ready_]
+    std::unordered_map<session_id, reply> replies_;
+    std::vector<session_id> ready_;         // [ids with output in replies_]
+    std::unique_ptr<session_scheduler> scheduler_;
+};
+
+#endif
+
+
+// [Not part of Crowther's code. A replay log is a compact binary record of
+//  one game: the seed and the fingerprint of the tables it was played with,
+//  then in the order they happened, each line of input, each call of ran()
+//  with its call site and result, each location passed to trace_location,
+//  and the FNV-1a hash of the output typed before each request for input.
+//  Logs may be concatenated; replay() re-runs a game from its log and checks
+//  it goes exactly as it went before.
+//
+//  header:   "ADVL" version(1) fingerprint(8) seed(8)
+//  events:   'I' length line | 'R' call-site result(8) | 'L' location
+//            | 'O' hash(8) | 'E' (end of log)
+//  Lengths, call sites and locations are LEB128; the rest little endian.]
+namespace replay_log {
+
+constexpr char magic[4] = {'A', 'D', 'V', 'L'};
+constexpr unsigned char version = 1;
+
+enum event : char {
+    input = 'I', random = 'R', location = 'L', output = 'O', end = 'E'
+};
+
+inline void put_varint(std::string & log, uint_least64_t n)
+{
+    while (n >= 0x80) {
+        log += static_cast<char>((n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    log += static_cast<char>(n);
+}
+
+inline void put_u64(std::string & log, uint_least64_t n)
+{
+    for (int i = 0; i < 8; ++i, n >>= 8)
+        log += static_cast<char>(n & 0xFF);
+}
+
+// Read the log from front to back; fail() throws for a log that is cut short.
+class reader {
+public:
+    explicit reader(std::string_view log) : log_(log) {}
+
+    bool empty() const { return pos_ == log_.size(); }
+    size_t position() const { return pos_; }
+    char peek() const { return empty() ? '\0' : log_[pos_]; }
+
+    char get()
+    {
+        if (empty())
+            fail();
+        return log_[pos_++];
+    }
+
+    uint_least64_t varint()
+    {
+        uint_least64_t n = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const auto c = static_cast<unsigned char>(get());
+            n |= static_cast<uint_least64_t>(c & 0x7F) << shift;
+            if (!(c & 0x80))
+                return n;
+        }
+        fail();
+    }
+
+    uint_least64_t u64()
+    {
+        uint_least64_t n = 0;
+        for (int i = 0; i < 8; ++i)
+            n |= static_cast<uint_least64_t>(static_cast<unsigned char>(get())) << (8 * i);
+        return n;
+    }
+
+    std::string_view bytes(size_t count)
+    {
+        if (log_.size() - pos_ < count)
+            fail();
+        pos_ += count;
+        return log_.substr(pos_ - count, count);
+    }
+
+    [[noreturn]] static void fail()
+    {
+        throw scaffolding::adventure_exception("replay log: truncated or corrupt");
+    }
+
+private:
+    std::string_view log_;
+    size_t pos_ = 0;
+};
+
+// FNV-1a of everything typed, however it was split into pieces
+class output_hash {
+public:
+    void add(std::string_view text)
+    {
+        for (const char c : text)
+            h_ = (h_ ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+    void add(int n) { add(std::string_view(std::to_string(n))); }
+    uint_least64_t value() const { return h_; }
+    void reset() { h_ = 0xCBF29CE484222325ULL; }
+
+private:
+    uint_least64_t h_ = 0xCBF29CE484222325ULL;
+};
+
+inline double as_double(uint_least64_t bits)
+{
+    double d;
+    static_assert(sizeof(d) == sizeof(bits));
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+inline uint_least64_t as_bits(double d)
+{
+    uint_least64_t bits;
+    std::memcpy(&bits, &d, sizeof(d));
+    return bits;
+}
+
+// Remove the first complete log from the front of the given logs and return it.
+inline std::string_view next(std::string_view & logs)
+{
+    reader r(logs);
+    if (r.bytes(4) != std::string_view(magic, 4) || static_cast<unsigned char>(r.get()) != version)
+        reader::fail();
+    r.bytes(16);
+    for (;;) {
+        switch (r.get()) {
+        case input:     r.bytes(r.varint());          break;
+        case random:    r.varint(); r.bytes(8);       break;
+        case location:  r.varint();                   break;
+        case output:    r.bytes(8);                   break;
+        case end: {
+            const std::string_view log = logs.substr(0, r.position());
+            logs.remove_prefix(r.position());
+            return log;
+        }
+        default:        reader::fail();
+        }
+    }
+}
+
+} // namespace replay_log
+
+
+// [Not part of Crowther's code. An advent_io that passes everything through
+//  to the given io, recording the game in a replay log as it goes. Input
+//  read with getline() is recorded; a caller that gives a session its input
+//  by other means must pass each line to input() before giving it to the
+//  session. The log is complete once finish() has been called, which the
+//  destructor does if need be.]
+class advent_io_recorder : public scaffolding::advent_io {
+public:
+    using advent_io::type;
+
+    advent_io_recorder(scaffolding::advent_io & io, std::string & log, const world & w, uint_least64_t seed)
+    : io_(io), log_(log)
+    {
+        log_.append(replay_log::magic, 4);
+        log_ += static_cast<char>(replay_log::version);
+        replay_log::put_u64(log_, w.fingerprint);
+        replay_log::put_u64(log_, seed);
+    }
+    ~advent_io_recorder() override { finish(); }
+
+    // record the given line as the game's next input
+    void input(const std::string & line)
+    {
+        end_output();
+        log_ += replay_log::input;
+        replay_log::put_varint(log_, line.size());
+        log_ += line;
+    }
+
+    void finish()
+    {
+        if (!finished_) {
+            end_output();
+            log_ += replay_log::end;
+            finished_ = true;
+        }
+    }
+
+    std::string getline() override
+    {
+        std::string line = io_.getline();
+        input(line);
+        return line;
+    }
+
+    void type(const std::string & msg) override { output_.add(msg); io_.type(msg); }
+    void type(std::string_view msg) override { output_.add(msg); io_.type(msg); }
+    void type(int n) override { output_.add(n); io_.type(n); }
+
+    void trace_location(int loc) override
+    {
+        log_ += replay_log::location;
+        replay_log::put_varint(log_, static_cast<unsigned>(loc));
+        io_.trace_location(loc);
+    }
+
+    double ran(int call_site, scaffolding::prng & game_prng) override
+    {
+        const double r = io_.ran(call_site, game_prng);
+        log_ += replay_log::random;
+        replay_log::put_varint(log_, static_cast<unsigned>(call_site));
+        replay_log::put_u64(log_, replay_log::as_bits(r));
+        return r;
+    }
+
+    scaffolding::instrumentation * instruments() override { return io_.instruments(); }
+    scaffolding::label_set * labels_reached() override { return io_.labels_reached(); }
+
+private:
+    void end_output()
+    {
+        log_ += replay_log::output;
+        replay_log::put_u64(log_, output_.value());
+        output_.reset();
+    }
+
+    scaffolding::advent_io & io_;
+    std::string & log_;
+    replay_log::output_hash output_;
+    bool finished_ = false;
+};
+
+
+// [Not part of Crowther's code. Replay the one game recorded in the given log
+//  with the given tables, headless: each random number is taken from the log,
+//  and each call of ran(), each location and the hash of each response must
+//  be as recorded. Return an empty string if the game went exactly as it did
+//  before, otherwise a note of where it first differed. Given a list of
+//  tables, the game is replayed with those it was recorded with.]
+std::string replay(const std::vector<shared_world> & worlds, std::string_view log)
+{
+    class advent_io_replayer : public scaffolding::advent_io {
+    public:
+        using advent_io::type;
+
+        explicit advent_io_replayer(replay_log::reader & log) : log_(log) {}
+
+        std::string getline() override
+        {
+            throw scaffolding::adventure_exception("advent_io_replayer: no input");
+        }
+
+        void type(const std::string & msg) override { output.add(msg); }
+        void type(std::string_view msg) override { output.add(msg); }
+        void type(int n) override { output.add(n); }
+
+        void trace_location(int loc) override
+        {
+            if (log_.get() != replay_log::location || log_.varint() != static_cast<unsigned>(loc))
+                throw scaffolding::adventure_exception("location differs");
+        }
+
+        double ran(int call_site, scaffolding::prng &) override
+        {
+            if (log_.get() != replay_log::random || log_.varint() != static_cast<unsigned>(call_site))
+                throw scaffolding::adventure_exception("ran() call differs");
+            return replay_log::as_double(log_.u64());
+        }
+
+        replay_log::output_hash output;
+
+    private:
+        replay_log::reader & log_;
+    };
+
+    size_t steps = 0;
+    try {
+        replay_log::reader r(log);
+        if (r.bytes(4) != std::string_view(replay_log::magic, 4)
+                || static_cast<unsigned char>(r.get()) != replay_log::version)
+            return "not a replay log";
+        const uint_least64_t fingerprint = r.u64();
+        const auto w = std::find_if(worlds.begin(), worlds.end(),
+            [&](const shared_world & candidate) { return candidate->fingerprint == fingerprint; });
+        if (w == worlds.end())
+            return "recorded with different tables";
+        session_options options;
+        options.seed = r.u64();
+        session s(*w, options);
+        advent_io_replayer io(r);
+        s.start(io);
+        for (;;) {
+            if (r.get() != replay_log::output || r.u64() != io.output.value())
+                throw scaffolding::adventure_exception("output differs");
+            io.output.reset();
+            const char e = r.get();
+            if (e == replay_log::end)
+                return {};
+            if (e != replay_log::input)
+                throw scaffolding::adventure_exception("input expected");
+            const std::string line(r.bytes(r.varint()));
+            ++steps;
+            s.step(line, io);
+        }
+    }
+    catch (const std::exception & e) {
+        return "step " + std::to_string(steps) + ": " + e.what();
+    }
+}
+
+std::string replay(const shared_world & w, std::string_view log)
+{
+    return replay(std::vector<shared_world>{w}, log);
+}
+
+
+// [Not part of Crowther's code. The results of replay_all().]
+struct replay_summary {
+    size_t games = 0;
+    size_t failures = 0;
+    std::string first_failure;  // [the game number and why, of the first failure found]
+    double seconds = 0;
+};
+
+// [Not part of Crowther's code. Replay every game in the given concatenated
+//  logs, spread over the given number of threads (0: one per hardware thread),
+//  each with whichever of the given tables it was recorded with.]
+replay_summary replay_all(const std::vector<shared_world> & worlds, std::string_view logs, unsigned threads = 0)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::string_view> games;
+    replay_summary summary;
+    try {
+        while (!logs.empty())
+            games.push_back(replay_log::next(logs));
+    }
+    catch (const scaffolding::adventure_exception & e) {
+        ++summary.failures;
+        summary.first_failure = "game " + std::to_string(games.size()) + ": " + e.what();
+    }
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<size_t> next_game{0};
+    std::mutex failure_mutex;
+    auto work = [&] {
+        for (size_t n; (n = next_game++) < games.size(); ) {
+            const std::string why = replay(worlds, games[n]);
+            if (!why.empty()) {
+                std::lock_guard<std::mutex> lock(failure_mutex);
+                if (summary.failures++ == 0)
+                    summary.first_failure = "game " + std::to_string(n) + ": " + why;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(work);
+    work();
+    for (auto & thread : pool)
+        thread.join();
+
+    summary.games = games.size();
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+replay_summary replay_all(const shared_world & w, std::string_view logs, unsigned threads = 0)
+{
+    return replay_all(std::vector<shared_world>{w}, logs, threads);
+}
+
+
+// [Not part of Crowther's code. The map of the cave as a graph, built from
+//  the key and travel tables for offline analysis. The motions that lead
+//  out of location loc are edges[first[loc]..first[loc+1]-1], in the order
+//  the walk at label 9 tries them; a motion that an earlier entry for the
+//  same location would always take first is left out. Motion 1 is any
+//  motion. A travel entry to 300 or above is one of the special transitions
+//  at labels 22..39, whose outcome depends on the state of the game or on
+//  chance; it is given as one edge to each location it may lead to, each
+//  with the special code.]
+struct map_edge {
+    int_least16_t to;       // [the destination location]
+    int_least16_t motion;   // [the motion word number, K]
+    int_least16_t special;  // [300.. for a special transition, else 0]
+};
+
+struct map_graph {
+    static constexpr int locations = 301;   // [0..300; 0 is unused]
+    std::array<int, locations + 1> first{};
+    std::vector<map_edge> edges;
+};
+
+// [The locations each special transition may lead to; 0 ends each list.
+//  Transition 305 (label 31, jumping across the fissure) ends the game.]
+constexpr std::array<std::array<int_least16_t, 4>, 15> special_destinations = {{
+    {6, 5},         // [300: label 22, at random]
+    {23, 9},        // [301: label 23, if the grate is open]
+    {9, 8},         // [302: label 24, if the grate is open]
+    {20, 15},       // [303: label 25, if carrying the nugget]
+    {22, 14},       // [304: label 26, if carrying the nugget]
+    {},             // [305: label 31]
+    {27, 31},       // [306: label 27, if the fissure is bridged]
+    {28, 32},       // [307: label 28, if the snake is gone]
+    {29, 32},       // [308: label 29, if the snake is gone]
+    {30, 32},       // [309: label 30, if the snake is gone]
+    {8, 9},         // [310: label 33, if the grate is open]
+    {68, 65},       // [311: label 34, at random]
+    {65, 39, 70},   // [312: label 36, at random]
+    {66, 71, 72},   // [313: label 37, at random]
+    {66, 77},       // [314: label 39, at random]
+}};
+
+map_graph build_map_graph(const world & w)
+{
+    map_graph g;
+    for (int loc = 0; loc < map_graph::locations; ++loc) {
+        g.first[loc] = static_cast<int>(g.edges.size());
+        std::array<bool, 1024> taken{};
+        for (int kk = w.key[loc]; kk >= 1 && kk <= 1000; ++kk) {
+            const int ll = std::abs(w.travel[kk]);
+            const int motion = ll % 1024, to = ll / 1024;
+            if (!taken[motion] && !taken[1]) {
+                taken[motion] = true;
+                if (to < 300)
+                    g.edges.push_back({static_cast<int_least16_t>(to), static_cast<int_least16_t>(motion), 0});
+                else if (to - 300 < static_cast<int>(special_destinations.size())) {
+                    for (const int_least16_t dest : special_destinations[to - 300]) {
+                        if (dest != 0)
+                            g.edges.push_back({dest, static_cast<int_least16_t>(motion), static_cast<int_least16_t>(to)});
+                    }
+                }
+            }
+            if (w.travel[kk] < 0)
+                break;
+        }
+    }
+    g.first[map_graph::locations] = static_cast<int>(g.edges.size());
+    return g;
+}
+
+
+// [Not part of Crowther's code. The shortest routes between every pair of
+//  locations in a map_graph, found with a breadth-first search from each
+//  location; the searches are shared among the given number of threads
+//  (0: one per hardware thread). If follow_special is false, special
+//  transitions are not taken.]
+class map_paths {
+public:
+    static constexpr int locations = map_graph::locations;
+    static constexpr int_least16_t unreachable = -1;
+
+    map_paths(const map_graph & g, bool follow_special = true, unsigned threads = 0)
+    : graph_(g), distance_(locations * locations, unreachable), via_(locations * locations, -1)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<int> next_source{1};
+        auto work = [&] {
+            std::vector<int_least16_t> queue(locations);
+            for (int from; (from = next_source++) < locations; )
+                search(from, follow_special, queue);
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(work);
+        work();
+        for (auto & thread : pool)
+            thread.join();
+    }
+
+    // the fewest motions from one location to another, or unreachable
+    int distance(int from, int to) const { return distance_.at(index(from, to)); }
+    bool reachable(int from, int to) const { return distance(from, to) != unreachable; }
+
+    // the motions of a shortest route from one location to another, in order
+    std::vector<map_edge> path(int from, int to) const
+    {
+        std::vector<map_edge> route;
+        if (!reachable(from, to))
+            return route;
+        for (int at = to; at != from; ) {
+            const int e = via_[index(from, at)];
+            route.push_back(graph_.edges[e]);
+            at = source_[e];
+        }
+        std::reverse(route.begin(), route.end());
+        return route;
+    }
+
+private:
+    static size_t index(int from, int to)
+    {
+        if (from < 0 || from >= locations || to < 0 || to >= locations)
+            throw scaffolding::adventure_exception("map_paths: no such location");
+        return static_cast<size_t>(from) * locations + static_cast<size_t>(to);
+    }
+
+    // breadth-first search from one location (each thread writes only its own rows)
+    void search(int from, bool follow_special, std::vector<int_least16_t> & queue)
+    {
+        int_least16_t * const distance = &distance_[index(from, 0)];
+        int * const via = &via_[index(from, 0)];
+        size_t head = 0, tail = 0;
+        distance[from] = 0;
+        queue[tail++] = static_cast<int_least16_t>(from);
+        while (head < tail) {
+            const int at = queue[head++];
+            for (int e = graph_.first[at]; e < graph_.first[at + 1]; ++e) {
+                const map_edge & edge = graph_.edges[e];
+                if ((edge.special && !follow_special) || distance[edge.to] != unreachable)
+                    continue;
+                distance[edge.to] = static_cast<int_least16_t>(distance[at] + 1);
+                via[edge.to] = e;
+                queue[tail++] = edge.to;
+            }
+        }
+    }
+
+    const map_graph & graph_;
+    std::vector<int_least16_t> distance_;
+    std::vector<int> via_;                  // [the edge by which each location was reached]
+    std::vector<int_least16_t> source_ = edge_sources(graph_);
+
+    static std::vector<int_least16_t> edge_sources(const map_graph & g)
+    {
+        std::vector<int_least16_t> source(g.edges.size());
+        for (int loc = 0; loc < locations; ++loc)
+            for (int e = g.first[loc]; e < g.first[loc + 1]; ++e)
+                source[e] = static_cast<int_least16_t>(loc);
+        return source;
+    }
+};
+
+
+// [Not part of Crowther's code. Return the first word in the keyword table
+//  for the given motion, e.g. "WEST" for 44, or "*" for 1 (any motion).]
+std::string motion_word(const world & w, int motion)
+{
+    if (motion == 1)
+        return "*";
+    for (int iu = 1; iu <= 1000 && w.ktab[iu] != -1; ++iu) {
+        if (w.ktab[iu] == motion) {
+            std::string word = scaffolding::as_string(w.atab[iu]);
+            word.erase(word.find_last_not_of(' ') + 1);
+            return word;
+        }
+    }
+    return std::to_string(motion);
+}
+
+
+// [Not part of Crowther's code. Every distinct word in the keyword table, in
+//  the order of the table, as the player would type it.]
+std::vector<std::string> vocabulary_words(const world & w)
+{
+    std::vector<std::string> words;
+    for (int iu = 1; iu <= 1000 && w.ktab[iu] != -1; ++iu) {
+        std::string word = scaffolding::as_string(w.atab[iu]);
+        word.erase(word.find_last_not_of(' ') + 1);
+        if (std::find(words.begin(), words.end(), word) == words.end())
+            words.push_back(word);
+    }
+    return words;
+}
+
+
+// [Not part of Crowther's code. Return the labels of Crowther's code in the
+//  game, each of which the session marks as it passes; see labels_reached().]
+scaffolding::label_set game_labels()
+{
+    static constexpr std::array<int, 102> labels = {
+        2, 7, 8, 9, 10, 11, 12, 19, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33,
+        34, 35, 36, 37, 38, 39, 40, 60, 63, 65, 69, 71, 74, 75, 77, 79, 81, 82, 83,
+        502, 1100, 2000, 2001, 2003, 2009, 2010, 2011, 2012, 2020, 2021, 2023, 2025,
+        2026, 2027, 2028, 2032, 2033, 2034, 2035, 2036, 2037, 3000, 5000, 5004, 5014,
+        5031, 5033, 5034, 5062, 5066, 5081, 5097, 5098, 5102, 5104, 5105, 5107, 5109,
+        5160, 5200, 5300, 5302, 5307, 5309, 5311, 5314, 5316, 5333, 5502, 5504, 5505,
+        5506, 9000, 9002, 9003, 9004, 9005, 9401, 9403, 9404, 9406
+    };
+    scaffolding::label_set set;
+    for (const int n : labels)
+        set.set(static_cast<size_t>(n));
+    return set;
+}
+
+
+// [Not part of Crowther's code. What explore() is to do, and what it found.]
+struct explore_options {
+    int depth = 3;                  // [words to type after resuming from INIT DONE]
+    size_t max_states = 1000000;    // [states to keep; the search is cut short after this many]
+    unsigned threads = 0;           // [0: one per hardware thread]
+};
+
+struct explore_report {
+    size_t states = 0;              // [distinct states reached, counting the first]
+    size_t steps = 0;               // [words typed]
+    size_t duplicates = 0;          // [steps that led to a state already reached]
+    size_t terminated = 0;          // [steps after which the game was over]
+    size_t errors = 0;              // [steps that threw an exception]
+    std::string first_error;        // [the word typed and the exception, for one of them]
+    int depth = 0;                  // [the depth the search reached]
+    std::array<bool, 301> locations{};      // [the locations passed to trace_location]
+    std::array<bool, 15> resume_points{};   // [the ACCEPTs and PAUSEs waited at]
+    scaffolding::label_set labels;          // [the labels of Crowther's code passed]
+    double seconds = 0;
+};
+
+// [Not part of Crowther's code. Explore the game breadth first: from the
+//  state after "g" at INIT DONE, type each of the given words in each state
+//  reached, to the given depth. Each state is saved and restored as a
+//  session_snapshot. States are told apart by session::state_hash(), and
+//  each is explored once. The random numbers each step is given are drawn
+//  from a generator seeded by the state and the word, so the search finds
+//  the same states however many threads share it, unless it's cut short by
+//  max_states.]
+explore_report explore(const shared_world & w, const std::vector<std::string> & words, explore_options options = {})
+{
+    class advent_io_explorer : public scaffolding::advent_io {
+    public:
+        using advent_io::type;
+
+        explicit advent_io_explorer(explore_report & coverage) : coverage_(coverage) {}
+
+        std::string getline() override { throw scaffolding::adventure_exception("advent_io_explorer: no input"); }
+        void type(const std::string &) override {}
+        void type(std::string_view) override {}
+        void type(int) override {}
+        void trace_location(int loc) override
+        {
+            if (loc >= 0 && loc < static_cast<int>(coverage_.locations.size()))
+                coverage_.locations[loc] = true;
+        }
+        double ran(int, scaffolding::prng &) override { return random.uniform(); }
+        scaffolding::label_set * labels_reached() override { return &coverage_.labels; }
+
+        scaffolding::prng random;
+
+    private:
+        explore_report & coverage_;
+    };
+
+    // (the set of states reached, split among locks so threads rarely wait)
+    constexpr size_t shards = 64;
+    struct shard {
+        std::mutex mutex;
+        std::unordered_set<uint_least64_t> states;
+    };
+    std::vector<shard> seen(shards);
+    std::atomic<size_t> states{0};
+    auto first_time = [&](uint_least64_t h) {
+        shard & sh = seen[h % shards];
+        std::lock_guard<std::mutex> lock(sh.mutex);
+        return sh.states.insert(h).second;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    explore_report report;
+    std::vector<session_snapshot> frontier;
+    {
+        session s(w);
+        advent_io_explorer io(report);
+        s.start(io);
+        s.step("g", io);
+        first_time(s.state_hash());
+        states = 1;
+        frontier.push_back(s.save());
+        report.resume_points.at(s.resume_point()) = true;
+    }
+
+    if (options.threads == 0)
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int depth = 1; depth <= options.depth && !frontier.empty(); ++depth) {
+        std::vector<explore_report> found(options.threads);
+        std::vector<std::vector<session_snapshot>> next(options.threads);
+        std::atomic<size_t> next_state{0};
+        auto work = [&](unsigned t) {
+            session s(w);
+            advent_io_explorer io(found[t]);
+            for (size_t n; (n = next_state++) < frontier.size(); ) {
+                s.restore(frontier[n]);
+                const uint_least64_t from = s.state_hash();
+                for (size_t word = 0; word < words.size(); ++word) {
+                    if (word > 0)
+                        s.restore(frontier[n]);
+                    io.random.reseed(from ^ (word * 0x9E3779B97F4A7C15ULL));
+                    ++found[t].steps;
+                    try {
+                        if (s.step(words[word], io) == session_status::terminated) {
+                            ++found[t].terminated;
+                            continue;
+                        }
+                        found[t].resume_points.at(s.resume_point()) = true;
+                        if (!first_time(s.state_hash()))
+                            ++found[t].duplicates;
+                        else if (states++ < options.max_states)
+                            next[t].push_back(s.save());
+                    }
+                    catch (const std::exception & e) {
+                        // (e.g. BACK as the first move: Crowther's code then goes to location 9999)
+                        if (found[t].errors++ == 0)
+                            found[t].first_error = words[word] + ": " + e.what();
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < options.threads; ++t)
+            pool.emplace_back(work, t);
+        work(0);
+        for (auto & thread : pool)
+            thread.join();
+
+        frontier.clear();
+        for (unsigned t = 0; t < options.threads; ++t) {
+            report.steps += found[t].steps;
+            report.duplicates += found[t].duplicates;
+            report.terminated += found[t].terminated;
+            if (report.errors == 0 && found[t].errors != 0)
+                report.first_error = found[t].first_error;
+            report.errors += found[t].errors;
+            for (size_t loc = 0; loc < report.locations.size(); ++loc)
+                report.locations[loc] = report.locations[loc] || found[t].locations[loc];
+            for (size_t p = 0; p < report.resume_points.size(); ++p)
+                report.resume_points[p] = report.resume_points[p] || found[t].resume_points[p];
+            report.labels |= found[t].labels;
+            frontier.insert(frontier.end(), next[t].begin(), next[t].end());
+        }
+        report.depth = depth;
+    }
+
+    report.states = std::min<size_t>(states, options.max_states);
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+
+// Load the Adventure data file into a new world that may be shared.
+template <typename input_stream>
+shared_world load_world(
+    input_stream & advdat,          // Adventure data file stream
+    scaffolding::advent_io & io,    // (used only if the data file is too big)
+    load_profile * profile = nullptr)
+{
+    // [A world is ~200KB: too big for the stack.]
+    auto w = std::make_shared<world>();
+    load(advdat, io, *w, profile);
+    return w;
+}
+
+// [Not part of Crowther's code. Load the Adventure data file at the given
+//  path, e.g. doc/advdat.77-03-11.txt, into a new world: the file is mapped
+//  into memory and parsed where it lies, in one pass.]
+shared_world load_world_file(const std::string & path, scaffolding::advent_io & io, load_profile * profile = nullptr)
+{
+    const scaffolding::mapped_file file(path);
+    scaffolding::text_view_stream advdat(file.text());
+    return load_world(advdat, io, profile);
+}
+
+
+// Load the Adventure data file then play the game.
+template <typename input_stream>
+void adventure(
+    input_stream & advdat,          // Adventure data file stream
+    scaffolding::advent_io & io)    // communication with outside world
+{
+    adventure(load_world(advdat, io), io);
+}
+
+
+
+// [The world image functions are not part of Crowther's code.]
+// A world image is a small header followed by the bytes of the world struct.
+// The header records the image format version and the size and byte order
+// of the tables, so an image written by an incompatible build is rejected
+// rather than misread.
+constexpr char world_image_magic[8] = {'A','D','V','W','O','R','L','D'};
+constexpr uint_least32_t world_image_version = 7;
+constexpr uint_least64_t world_image_byte_order = 0x0102030405060708ULL;
+
+struct world_image_header {
+    char magic[8];
+    uint_least32_t version;
+    uint_least32_t size;
+    uint_least64_t byte_order;
+};
+
+static_assert(std::is_trivially_copyable_v<world>);
+
+
+// Write the given world to the given stream in binary image format.
+void write_image(std::ostream & os, const world & w)
+{
+    world_image_header header{};
+    std::copy(std::begin(world_image_magic), std::end(world_image_magic), header.magic);
+    header.version = world_image_version;
+    header.size = sizeof(world);
+    header.byte_order = world_image_byte_order;
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char *>(&w), sizeof(world));
+    if (!os)
+        throw scaffolding::adventure_exception("write_image(): write failed");
+}
+
+
+// Read a world previously written with write_image() from the given stream.
+void read_image(std::istream & is, world & w)
+{
+    world_image_header header{};
+    if (!is.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || !std::equal(std::begin(world_image_magic), std::end(world_image_magic), header.magic))
+        throw scaffolding::adventure_exception("read_image(): not a world image");
+    if (header.version != world_image_version
+        || header.size != sizeof(world)
+        || header.byte_order != world_image_byte_order)
+        throw scaffolding::adventure_exception("read_image(): incompatible world image");
+    if (!is.read(reinterpret_cast<char *>(&w), sizeof(world)))
+        throw scaffolding::adventure_exception("read_image(): truncated world image");
+}
+
+
+// [The shared world functions are not part of Crowther's code.]
+// A shared world is a world image in a POSIX shared memory object, with the
+// world struct at a fixed, aligned offset, so any number of processes may map
+// the tables the first process loaded rather than each loading its own copy.
+// The world holds no pointers, only indexes into its own tables, so it may
+// be mapped at any address. Each process maps it read-only.
+constexpr size_t shared_world_offset = 64;
+static_assert(sizeof(world_image_header) <= shared_world_offset
+    && shared_world_offset % alignof(world) == 0);
+
+// (shared memory object names have one leading '/')
+std::string shared_world_name(const std::string & name)
+{
+    return name.starts_with('/') ? name : '/' + name;
+}
+
+
+// Place the given world in a new shared memory object of the given name,
+// replacing any shared world already of that name. (Processes that have
+// already mapped the old one keep it until they unmap it.)
+void publish_shared_world(const std::string & name, const world & w)
+{
+#if ADVENT_HAVE_MMAP
+    const std::string shm_name = shared_world_name(name);
+    ::shm_unlink(shm_name.c_str());
+    const int fd = ::shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0444);
+    if (fd < 0)
+        throw scaffolding::adventure_exception("publish_shared_world(): cannot create shared memory");
+    const size_t size = shared_world_offset + sizeof(world);
+    void * p = ::ftruncate(fd, static_cast<off_t>(size)) == 0
+        ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        ::shm_unlink(shm_name.c_str());
+        throw scaffolding::adventure_exception("publish_shared_world(): cannot map shared memory");
+    }
+
+    // (the header is written last, so a process attaching to a shared world
+    //  that is still being written sees no magic and rejects it)
+    char * const segment = static_cast<char *>(p);
+    std::memcpy(segment + shared_world_offset, &w, sizeof(world));
+    world_image_header header{};
+    std::copy(std::begin(world_image_magic), std::end(world_image_magic), header.magic);
+    header.version = world_image_version;
+    header.size = sizeof(world);
+    header.byte_order = world_image_byte_order;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(segment, &header, sizeof(header));
+    ::munmap(p, size);
+#else
+    (void)name;
+    (void)w;
+    throw scaffolding::adventure_exception("publish_shared_world(): no shared memory on this system");
+#endif
+}
+
+
+// Return the world in the shared memory object of the given name. Its
+// tables are not copied; the object stays mapped until the last session
+// using the returned world is done with it.
+shared_world attach_shared_world(const std::string & name)
+{
+#if ADVENT_HAVE_MMAP
+    const int fd = ::shm_open(shared_world_name(name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw scaffolding::adventure_exception("attach_shared_world(): no such shared world");
+    const size_t size = shared_world_offset + sizeof(world);
+    struct stat st;
+    void * p = ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size
+        ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (p == MAP_FAILED)
+        throw scaffolding::adventure_exception("attach_shared_world(): incompatible shared world");
+    std::shared_ptr<const void> mapping(p, [size](const void * q) {
+        ::munmap(const_cast<void *>(q), size);
+    });
+
+    world_image_header header;
+    std::memcpy(&header, p, sizeof(header));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!std::equal(std::begin(world_image_magic), std::end(world_image_magic), header.magic))
+        throw scaffolding::adventure_exception("attach_shared_world(): not a world image");
+    if (header.version != world_image_version
+        || header.size != sizeof(world)
+        || header.byte_order != world_image_byte_order)
+        throw scaffolding::adventure_exception("attach_shared_world(): incompatible shared world");
+    // (the world was memcpy'd into place, which began its lifetime there)
+    return shared_world(mapping,
+        reinterpret_cast<const world *>(static_cast<const char *>(p) + shared_world_offset));
+#else
+    (void)name;
+    throw scaffolding::adventure_exception("attach_shared_world(): no shared memory on this system");
+#endif
+}
+
+
+// Remove the shared world of the given name. Processes that have mapped it
+// keep it until they unmap it.
+void unlink_shared_world(const std::string & name)
+{
+#if ADVENT_HAVE_MMAP
+    ::shm_unlink(shared_world_name(name).c_str());
+#else
+    (void)name;
+#endif
+}
+
+
+
+
+
+/*
+       ###    ########  ##     ## ########     ###    ######## 
+      ## ##   ##     ## ##     ## ##     ##   ## ##      ##    
+     ##   ##  ##     ## ##     ## ##     ##  ##   ##     ##    
+    ##     ## ##     ## ##     ## ##     ## ##     ##    ##    
+    ######### ##     ##  ##   ##  ##     ## #########    ##    
+    ##     ## ##     ##   ## ##   ##     ## ##     ##    ##    
+    ##     ## ########     ###    ########  ##     ##    ##    
+*/
+
+// The contents of the text file http://www.icynic.com/~don/jerz/advdat.77-03-31
+const std::string advdat_77_03_31{
+    "1\n"
+    "1    YOU ARE STANDING AT THE END OF A ROAD BEFORE A SMALL BRICK\n"
+    "1    BUILDING . AROUND YOU IS A FOREST. A SMALL\n"
+    "1    STREAM FLOWS OUT OF THE BUILDING AND DOWN A GULLY.\n"
+    "2    YOU HAVE WALKED UP A HILL, STILL IN THE FOREST\n"
+    "2    THE ROAD NOW SLOPES BACK DOWN THE OTHER SIDE OF THE HILL.\n"
+    "2    THERE IS A BUILDING IN THE DISTANCE.\n"
+    "3    YOU ARE INSIDE A BUILDING, A WELL HOUSE FOR A LARGE SPRING.\n"
+    "4    YOU ARE IN A VALLEY IN THE FOREST BESIDE A STREAM TUMBLING\n"
+    "4    ALONG A ROCKY BED.\n"
+    "5    YOU ARE IN OPEN FOREST, WITH A DEEP VALLEY TO ONE SIDE.\n"
+    "6    YOU ARE IN OPEN FOREST NEAR BOTH A VALLEY AND A ROAD.\n"
+    "7    AT YOUR FEET ALL THE WATER OF THE STREAM SPLASHES INTO A\n"
+    "7    2 INCH SLIT IN THE ROCK. DOWNSTREAM THE STREAMBED IS BARE ROCK.\n"
+    "8    YOU ARE IN A 20 FOOT DEPRESSION FLOORED WITH BARE DIRT. SET INTO\n"
+    "8    THE DIRT IS A STRONG STEEL GRATE MOUNTED IN CONCRETE. A DRY\n"
+    "8    STREAMBED LEADS INTO THE DEPRESSION.\n"
+    "9    YOU ARE IN A SMALL CHAMBER BENEATH A 3X3 STEEL GRATE TO THE\n"
+    "9    SURFACE. A LOW CRAWL OVER COBBLES LEADS INWARD TO THE WEST.\n"
+    "10   YOU ARE CRAWLING OVER COBBLES IN A LOW PASSAGE. THERE IS A\n"
+    "10   DIM LIGHT AT THE EAST END OF THE PASSAGE.\n"
+    "11   YOU ARE IN A DEBRIS ROOM, FILLED WITH STUFF WASHED IN FROM\n"
+    "11   THE SURFACE. A LOW WIDE PASSAGE WITH COBBLES BECOMES\n"
+    "11   PLUGGED WITH MUD AND DEBRIS HERE,BUT AN AWKWARD CANYON\n"
+    "11   LEADS UPWARD AND WEST.\n"
+    "11   A NOTE ON THE WALL SAYS 'MAGIC WORD XYZZY'.\n"
+    "12   YOU ARE IN AN AWKWARD SLOPING EAST/WEST CANYON.\n"
+    "13   YOU ARE IN A SPLENDID CHAMBER THIRTY FEET HIGH. THE WALLS\n"
+    "13   ARE FROZEN RIVERS OF ORANGE STONE. AN AWKWARD CANYON AND A\n"
+    "13   GOOD PASSAGE EXIT FROM EAST AND WEST SIDES OF THE CHAMBER.\n"
+    "14   AT YOUR FEET IS A SMALL PIT BREATHING TRACES OF WHITE MIST. AN\n"
+    "14   EAST PASSAGE ENDS HERE EXCEPT FOR A SMALL CRACK LEADING ON.\n"
+    "15   YOU ARE AT ONE END OF A VAST HALL STRETCHING FORWARD OUT OF\n"
+    "15   SIGHT TO THE WEST. THERE ARE OPENINGS TO EITHER SIDE. NEARBY, A WIDE\n"
+    "15   STONE STAIRCASE LEADS DOWNWARD. THE HALL IS FILLED WITH\n"
+    "15   WISPS OF WHITE MIST SWAYING TO AND FRO ALMOST AS IF ALIVE.\n"
+    "15   A COLD WIND BLOWS UP THE STAIRCASE. THERE IS A PASSAGE\n"
+    "15   AT THE TOP OF A DOME BEHIND YOU.\n"
+    "16   THE CRACK IS FAR TOO SMALL FOR YOU TO FOLLOW.\n"
+    "17   YOU ARE ON THE EAST BANK OF A FISSURE SLICING CLEAR ACROSS\n"
+    "17   THE HALL. THE MIST IS QUITE THICK HERE, AND THE FISSURE IS\n"
+    "17   TOO WIDE TO JUMP.\n"
+    "18   THIS IS A LOW ROOM WITH A CRUDE NOTE ON THE WALL.\n"
+    "18   IT SAYS 'YOU WON'T GET IT UP THE STEPS'.\n"
+    "19   YOU ARE IN THE HALL OF THE MOUNTAIN KING, WITH PASSAGES\n"
+    "19   OFF IN ALL DIRECTIONS.\n"
+    "20   YOU ARE AT THE BOTTOM OF THE PIT WITH A BROKEN NECK.\n"
+    "21   YOU DIDN'T MAKE IT\n"
+    "22   THE DOME IS UNCLIMBABLE\n"
+    "23   YOU CAN'T GO IN THROUGH A LOCKED STEEL GRATE!\n"
+    "24   YOU DON'T FIT DOWN A TWO INCH HOLE!\n"
+    "25   YOU CAN'T GO THROUGH A LOCKED STEEL GRATE.\n"
+    "27   YOU ARE ON THE WEST SIDE OF THE FISSURE IN THE HALL OF MISTS.\n"
+    "28   YOU ARE IN A LOW N/S PASSAGE AT A HOLE IN THE FLOOR.\n"
+    "28   THE HOLE GOES DOWN TO AN E/W PASSAGE.\n"
+    "29   YOU ARE IN THE SOUTH SIDE CHAMBER.\n"
+    "30   YOU ARE IN THE WEST SIDE CHAMBER OF HALL OF MT KING.\n"
+    "30   A PASSAGE CONTINUES WEST AND UP HERE.\n"
+    "31   THERE IS NO WAY ACROSS THE FISSURE.\n"
+    "32   YOU CAN'T GET BY THE SNAKE\n"
+    "33   YOU ARE IN A LARGE ROOM, WITH A PASSAGE TO THE SOUTH,\n"
+    "33   A PASSAGE TO THE WEST, AND A WALL OF BROKEN ROCK TO\n"
+    "33   THE EAST. THERE IS A LARGE 'Y2' ON A ROCK IN ROOMS CENTER.\n"
+    "34   YOU ARE IN A JUMBLE OF ROCK, WITH CRACKS EVERYWHERE.\n"
+    "35   YOU ARE AT A WINDOW ON A HUGE PIT, WHICH GOES UP AND\n"
+    "35   DOWN OUT OF SIGHT. A FLOOR IS INDISTINCTLY VISIBLE\n"
+    "35   OVER 50 FEET BELOW. DIRECTLY OPPOSITE YOU AND 25 FEET AWAY\n"
+    "35   THERE IS A SIMILAR WINDOW.\n"
+    "36   YOU ARE IN A DIRTY BROKEN PASSAGE. TO THE EAST IS A CRAWL.\n"
+    "36   TO THE WEST IS A LARGE PASSAGE. ABOVE YOU IS A HOLE TO\n"
+    "36   ANOTHER PASSAGE.\n"
+    "37   YOU ARE ON THE BRINK OF A SMALL CLEAN CLIMBABLE PIT.\n"
+    "37   A CRAWL LEADS WEST.\n"
+    "38   YOU ARE IN THE BOTTOM OF A SMALL PIT WITH A LITTLE\n"
+    "38   STREAM, WHICH ENTERS AND EXITS THROUGH TINY SLITS.\n"
+    "39   YOU ARE IN A LARGE ROOM FULL OF DUSTY ROCKS. THERE IS A\n"
+    "39   BIG HOLE IN THE FLOOR. THERE ARE CRACKS EVERYWHERE, AND\n"
+    "39   A PASSAGE LEADING EAST.\n"
+    "40   YOU HAVE CRAWLED THROUGH A VERY LOW WIDE PASSAGE PARALLEL\n"
+    "40   TO AND NORTH OF THE HALL OF MISTS.\n"
+    "41   YOU ARE AT THE WEST END OF HALL OF MISTS. A LOW WIDE CRAWL\n"
+    "41   CONTINUES WEST AND ANOTHER GOES NORTH. TO THE SOUTH IS A\n"
+    "41   LITTLE PASSAGE 6 FEET OFF THE FLOOR.\n"
+    "42   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "43   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "44   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "45   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "46   DEAD END\n"
+    "47   DEAD END\n"
+    "48   DEAD END\n"
+    "49   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "50   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "51   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "52   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "53   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "54   DEAD END\n"
+    "55   YOU ARE IN A MAZE OF TWISTY LITTLE PASSAGES, ALL ALIKE.\n"
+    "56   DEAD END\n"
+    "57   YOU ARE ON THE BRINK OF A THIRTY FOOT PIT WITH A MASSIVE\n"
+    "57   ORANGE COLUMN DOWN ONE WALL. YOU COULD CLIMB DOWN HERE\n"
+    "57   BUT YOU COULD NOT GET BACK UP. THE MAZE CONTINUES AT THIS\n"
+    "57   LEVEL.\n"
+    "58   DEAD END\n"
+    "59   YOU HAVE CRAWLED THROUGH A VERY LOW WIDE PASSAGE PARALLEL\n"
+    "59   TO AND NORTH OF THE HALL OF MISTS.\n"
+    "60   YOU ARE AT THE EAST END OF A VERY LONG HALL APPARENTLY\n"
+    "60   WITHOUT SIDE CHAMBERS. TO THE EAST A LOW WIDE CRAWL SLANTS\n"
+    "60   UP. TO THE NORTH A ROUND TWO FOOT HOLE SLANTS DOWN.\n"
+    "61   YOU ARE AT THE WEST END OF A VERY LONG FEATURELESS HALL.\n"
+    "62   YOU ARE AT A CROSSOVER OF A HIGH N/S PASSAGE AND A LOW E/W ONE.\n"
+    "63   DEAD END\n"
+    "64   YOU ARE AT A COMPLEX JUNCTION. A LOW HANDS AND KNEES\n"
+    "64   PASSAGE FROM THE NORTH JOINS A HIGHER CRAWL\n"
+    "64   FROM THE EAST TO MAKE  A WALKING PASSAGE GOING WEST\n"
+    "64   THERE IS ALSO A LARGE ROOM ABOVE. THE AIR IS DAMP HERE.\n"
+    "64   A SIGN IN MIDAIR HERE SAYS 'CAVE UNDER CONSTRUCTION BEYOND\n"
+    "64   THIS POINT. PROCEED AT OWN RISK.'\n"
+    "65   YOU ARE IN BEDQUILT, A LONG EAST/WEST PASSAGE WITH HOLES EVERYWHERE.\n"
+    "65   TO EXPLORE AT RANDOM SELECT NORTH, SOUTH, UP, OR DOWN.\n"
+    "66   YOU ARE IN A ROOM WHOSE WALLS RESEMBLE SWISS CHEESE.\n"
+    "66   OBVIOUS PASSAGES GO WEST,EAST,NE, AND\n"
+    "66   NW. PART OF THE ROOM IS OCCUPIED BY A LARGE BEDROCK BLOCK.\n"
+    "67   YOU ARE IN THE TWOPIT ROOM. THE FLOOR\n"
+    "67   HERE IS LITTERED WITH THIN ROCK SLABS, WHICH MAKE IT\n"
+    "67   EASY TO DESCEND THE PITS. THERE IS A PATH HERE BYPASSING\n"
+    "67   THE PITS TO CONNECT PASSAGES FROM EAST AND WEST.THERE\n"
+    "67   ARE HOLES ALL OVER, BUT THE ONLY BIG ONE IS ON THE WALL\n"
+    "67   DIRECTLY OVER THE EAST PIT WHERE YOU CAN'T GET TO IT.\n"
+    "68   YOU ARE IN A LARGE LOW CIRCULAR CHAMBER WHOSE FLOOR IS AN\n"
+    "68   IMMENSE SLAB FALLEN FROM THE CEILING(SLAB ROOM). EAST AND\n"
+    "68   WEST THERE ONCE WERE LARGE PASSAGES, BUT THEY ARE NOW FILLED\n"
+    "68   WITH BOULDERS. LOW SMALL PASSAGES GO NORTH AND SOUTH, AND THE\n"
+    "68   SOUTH ONE QUICKLY BENDS WEST AROUND THE BOULDERS.\n"
+    "69   YOU ARE IN A SECRET NS CANYON ABOVE A LARGE ROOM.\n"
+    "70   YOU ARE IN A SECRET N/S CANYON ABOVE A SIZABLE PASSAGE.\n"
+    "71   YOU ARE IN SECRET CANYON AT A JUNCTION OF THREE CANYONS,\n"
+    "71   BEARING NORTH, SOUTH, AND SE. THE NORTH ONE IS AS TALL\n"
+    "71   AS THE OTHER TWO COMBINED.\n"
+    "72   YOU ARE IN A LARGE LOW ROOM. CRAWLS LEAD N, SE, AND SW.\n"
+    "73   DEAD END CRAWL.\n"
+    "74   YOU ARE IN SECRET CANYON WHICH HERE RUNS E/W. IT CROSSES OVER\n"
+    "74   A VERY TIGHT CANYON 15 FEET BELOW. IF YOU GO DOWN YOU MAY\n"
+    "74   NOT BE ABLE TO GET BACK UP\n"
+    "75   YOU ARE AT A WIDE PLACE IN A VERY TIGHT N/S CANYON.\n"
+    "76   THE CANYON HERE BECOMES TO TIGHT TO GO FURTHER SOUTH.\n"
+    "77   YOU ARE IN A TALL E/W CANYON. A LOW TIGHT CRAWL GOES 3 FEET\n"
+    "77   NORTH AND SEEMS TO OPEN UP.\n"
+    "78   THE CANYON RUNS INTO A MASS OF BOULDERS - DEAD END.\n"
+    "79   THE STREAM FLOWS OUT THROUGH A PAIR OF 1 FOOT DIAMETER SEWER\n"
+    "79   PIPES. IT WOULD BE ADVISABLE TO USE THE DOOR.\n"
+    "-1  END\n"
+    "2\n"
+    "1    YOU'RE AT END OF ROAD AGAIN.\n"
+    "2    YOU'RE AT HILL IN ROAD.\n"
+    "3    YOU'RE INSIDE BUILDING.\n"
+    "4    YOU'RE IN VALLEY\n"
+    "5    YOU'RE IN FOREST\n"
+    "6    YOU'RE IN FOREST\n"
+    "7    YOU'RE AT SLIT IN STREAMBED\n"
+    "8    YOU'RE OUTSIDE GRATE\n"
+    "9    YOU'RE BELOW THE GRATE\n"
+    "10   YOU'RE IN COBBLE CRAWL\n"
+    "11   YOU'RE IN DEBRIS ROOM.\n"
+    "13   YOU'RE IN BIRD CHAMBER.\n"
+    "14   YOU'RE AT TOP OF SMALL PIT.\n"
+    "15   YOU'RE IN HALL OF MISTS.\n"
+    "17   YOU'RE ON EAST BANK OF FISSURE.\n"
+    "18   YOU'RE IN NUGGET OF GOLD ROOM.\n"
+    "19   YOU'RE IN HALL OF MT KING.\n"
+    "33   YOU'RE AT Y2\n"
+    "35   YOU'RE AT WINDOW ON PIT\n"
+    "36   YOU'RE IN DIRTY PASSAGE\n"
+    "39   YOU'RE N DUSTY ROCK ROOM.\n"
+    "41   YOU'RE AT WEST END OF HALL OF MISTS.\n"
+    "57   YOU'RE AT BRINK OF PIT.\n"
+    "60   YOU'RE AT EAST END OF LONG HALL.\n"
+    "66   YOU'RE IN SWISS CHEESE ROOM\n"
+    "67   YOU'RE IN TWOPIT ROOM\n"
+    "68   YOU'RE IN SLAB ROOM\n"
+    "-1\n"
+    "3\n"
+    "1   2   2   44\n"
+    "1   3   3   12  19  43\n"
+    "1   4   4   5   13  14  46  30\n"
+    "1   5   6   45  43\n"
+    "1   8   49\n"
+    "2   1   8   2   12  7   43  45  30\n"
+    "2   5   6   45  46\n"
+    "3   1   3   11  32  44\n"
+    "3   11  48\n"
+    "3   33  65\n"
+    "3   79  5   14\n"
+    "4   1   4   45\n"
+    "4   5   6   43  44  29\n"
+    "4   7   5   46  30\n"
+    "4   8   49\n"
+    "5   4   9   43  30\n"
+    "5   300 6   7   8   45\n"
+    "5   5   44  46\n"
+    "6   1   2   45\n"
+    "6   4   9   43  44  30\n"
+    "6   5   6   46\n"
+    "7   1   12\n"
+    "7   4   4   45\n"
+    "7   5   6   43  44\n"
+    "7   8   5   15  16  46  30\n"
+    "7   24  47  14  30\n"
+    "8   5   6   43  44  46\n"
+    "8   1   12\n"
+    "8   7   4   13  45\n"
+    "8   301 3   5   19  30\n"
+    "9   302 11  12\n"
+    "9   10  17  18  19  44\n"
+    "9   14  31\n"
+    "9   11  51\n"
+    "10  9   11  20  21  43\n"
+    "10  11  19  22  44  51\n"
+    "10  14  31\n"
+    "11  310 49\n"
+    "11  10  17  18  23  24  43\n"
+    "11  12  25  305 19  29  44\n"
+    "11  3   48\n"
+    "11  14  31\n"
+    "12  310 49\n"
+    "12  11  30  43  51\n"
+    "12  13  19  29  44\n"
+    "12  14  31\n"
+    "13  310 49\n"
+    "13  11  51\n"
+    "13  12  25  305 43\n"
+    "13  14  23  31  44\n"
+    "14  310 49\n"
+    "14  11  51\n"
+    "14  13  23  43\n"
+    "14  303 30  31  34\n"
+    "14  16  33  44\n"
+    "15  18  36  46\n"
+    "15  17  7   38  44\n"
+    "15  19  10  30  45\n"
+    "15  304 29  31  34  35  23  43\n"
+    "15  34  55\n"
+    "15  62  69\n"
+    "16  14  1\n"
+    "17  15  8   38  43\n"
+    "17  305 7\n"
+    "17  306 40  41  42  44  19  39\n"
+    "18  15  38  11  8   45\n"
+    "19  15  10  29  43\n"
+    "19  307 45  36\n"
+    "19  308 46  37\n"
+    "19  309 44  7\n"
+    "19  74  66\n"
+    "20  26  1\n"
+    "21  26  1\n"
+    "22  15  1\n"
+    "23  8   1\n"
+    "24  7   1\n"
+    "25  9   1\n"
+    "27  17  8   11  38\n"
+    "27  40  45\n"
+    "27  41  44\n"
+    "28  19  38  11  46\n"
+    "28  33  45\n"
+    "28  36  30  52\n"
+    "29  19  38  11  45\n"
+    "30  19  38  11  43\n"
+    "30  62  44  29\n"
+    "31  17  1\n"
+    "32  19  1\n"
+    "33  3   65\n"
+    "33  28  46\n"
+    "33  34  43  53  54\n"
+    "33  35  44\n"
+    "34  33  30\n"
+    "34  15  29\n"
+    "35  33  43  55\n"
+    "36  37  43  17\n"
+    "36  28  29  52\n"
+    "36  39  44\n"
+    "37  36  44  17\n"
+    "37  38  30  31  56\n"
+    "38  37  56  29\n"
+    "39  36  43\n"
+    "39  64  30  52  58\n"
+    "39  65  70\n"
+    "40  41  1\n"
+    "41  42  46  29  23  56\n"
+    "41  27  43\n"
+    "41  59  45\n"
+    "41  60  44  17\n"
+    "42  41  44\n"
+    "42  43  43\n"
+    "42  44  46\n"
+    "43  42  44\n"
+    "43  44  46\n"
+    "43  45  43\n"
+    "44  42  45\n"
+    "44  43  43\n"
+    "44  48  30\n"
+    "44  50  46\n"
+    "45  43  45\n"
+    "45  46  43\n"
+    "45  47  46\n"
+    "46  45  44  11\n"
+    "47  45  45  11\n"
+    "48  44  29  11\n"
+    "49  50  30  43\n"
+    "49  51  44\n"
+    "50  44  43\n"
+    "50  49  44  29\n"
+    "50  52  46\n"
+    "51  49  44\n"
+    "51  52  43\n"
+    "51  53  46\n"
+    "52  50  45\n"
+    "52  51  44\n"
+    "52  53  29\n"
+    "52  55  43\n"
+    "53  51  44\n"
+    "53  52  45\n"
+    "53  54  46\n"
+    "54  53  43  11\n"
+    "55  52  44\n"
+    "55  56  30\n"
+    "55  57  43\n"
+    "56  55  29  11\n"
+    "57  55  44\n"
+    "57  58  46\n"
+    "57  13  30  56\n"
+    "58  57  44  11\n"
+    "59  27  1\n"
+    "60  41  43  29\n"
+    "60  61  44\n"
+    "60  62  45  30\n"
+    "61  60  43  11\n"
+    "62  60  44\n"
+    "62  63  45\n"
+    "62  30  43\n"
+    "62  15  46\n"
+    "63  62  46  11\n"
+    "64  39  29  56  59\n"
+    "64  65  44\n"
+    "65  64  43\n"
+    "65  66  44\n"
+    "65  68  61\n"
+    "65  311 46\n"
+    "65  312 29\n"
+    "66  313 45\n"
+    "66  65  60\n"
+    "66  67  44\n"
+    "66  77  25\n"
+    "66  314 46\n"
+    "67  66  43\n"
+    "67  72  60\n"
+    "68  66  46\n"
+    "68  69  29\n"
+    "69  68  30\n"
+    "69  74  46\n"
+    "70  71  45\n"
+    "71  39  29\n"
+    "71  65  62\n"
+    "71  70  46\n"
+    "72  67  63\n"
+    "72  73  45\n"
+    "73  72  46\n"
+    "74  19  43\n"
+    "74  69  44\n"
+    "74  75  30\n"
+    "75  76  46\n"
+    "75  77  45\n"
+    "76  75  45\n"
+    "77  75  43\n"
+    "77  78  44\n"
+    "77  66  45\n"
+    "78  77  46\n"
+    "79  3   1\n"
+    "-1\n"
+    "4\n"
+    "2   ROAD\n"
+    "3   ENTER\n"
+    "3   DOOR\n"
+    "3   GATE\n"
+    "4   UPSTR\n"
+    "5   DOWNS\n"
+    "6   FORES\n"
+    "7   FORWA\n"
+    "7   CONTI\n"
+    "7   ONWAR\n"
+    "8   BACK\n"
+    "8   RETUR\n"
+    "8   RETRE\n"
+    "9   VALLE\n"
+    "10  STAIR\n"
+    "11  OUT\n"
+    "11  OUTSI\n"
+    "11  EXIT\n"
+    "11  LEAVE\n"
+    "12  BUILD\n"
+    "12  BLD\n"
+    "12  HOUSE\n"
+    "13  GULLY\n"
+    "14  STREA\n"
+    "15  ROCK\n"
+    "16  BED\n"
+    "17  CRAWL\n"
+    "18  COBBL\n"
+    "19  INWAR\n"
+    "19  INSID\n"
+    "19  IN\n"
+    "20  SURFA\n"
+    "21  NULL\n"
+    "21  NOWHE\n"
+    "22  DARK\n"
+    "23  PASSA\n"
+    "24  LOW\n"
+    "25  CANYO\n"
+    "26  AWKWA\n"
+    "29  UPWAR\n"
+    "29  UP\n"
+    "29  U\n"
+    "29  ABOVE\n"
+    "30  D\n"
+    "30  DOWNW\n"
+    "30  DOWN\n"
+    "31  PIT\n"
+    "32  OUTDO\n"
+    "33  CRACK\n"
+    "34  STEPS\n"
+    "35  DOME\n"
+    "36  LEFT\n"
+    "37  RIGHT\n"
+    "38  HALL\n"
+    "39  JUMP\n"
+    "40  MAGIC\n"
+    "41  OVER\n"
+    "42  ACROS\n"
+    "43  EAST\n"
+    "43  E\n"
+    "44  WEST\n"
+    "44  W\n"
+    "45  NORTH\n"
+    "45  N\n"
+    "46  SOUTH\n"
+    "46  S\n"
+    "47  SLIT\n"
+    "48  XYZZY\n"
+    "49  DEPRE\n"
+    "50  ENTRA\n"
+    "51  DEBRI\n"
+    "52  HOLE\n"
+    "53  WALL\n"
+    "54  BROKE\n"
+    "55  Y2\n"
+    "56  CLIMB\n"
+    "57  LOOK\n"
+    "57  EXAMI\n"
+    "57  TOUCH\n"
+    "57  LOOKA\n"
+    "58  FLOOR\n"
+    "59  ROOM\n"
+    "60  NE\n"
+    "61  SLAB\n"
+    "61  SLABR\n"
+    "62  SE\n"
+    "63  SW\n"
+    "64  NW\n"
+    "65  PLUGH\n"
+    "66  SECRE\n"
+    "67  CAVE\n"
+    "68  TURN\n"
+    "69  CROSS\n"
+    "70  BEDQU\n"
+    "1001    KEYS\n"
+    "1001    KEY\n"
+    "1002    LAMP\n"
+    "1002    HEADL\n"
+    "1003    GRATE\n"
+    "1004    CAGE\n"
+    "1005    ROD\n"
+    "1006    STEPS\n"
+    "1007    BIRD\n"
+    "1010    NUGGE\n"
+    "1010    GOLD\n"
+    "1011    SNAKE\n"
+    "1012    FISSU\n"
+    "1013    DIAMO\n"
+    "1014    SILVE\n"
+    "1014    BARS\n"
+    "1015    JEWEL\n"
+    "1016    COINS\n"
+    "1017    DWARV\n"
+    "1017    DWARF\n"
+    "1018    KNIFE\n"
+    "1018    KNIVE\n"
+    "1018    ROCK\n"
+    "1018    WEAPO\n"
+    "1018    BOULD\n"
+    "1019    FOOD\n"
+    "1019    RATIO\n"
+    "1020    WATER\n"
+    "1020    BOTTL\n"
+    "1021    AXE\n"
+    "1022    KNIFE\n"
+    "1023    CHEST\n"
+    "1023    BOX\n"
+    "1023    TREAS\n"
+    "2001    TAKE\n"
+    "2001    CARRY\n"
+    "2001    KEEP\n"
+    "2001    PICKU\n"
+    "2001    PICK\n"
+    "2001    WEAR\n"
+    "2001    CATCH\n"
+    "2001    STEAL\n"
+    "2001    CAPTU\n"
+    "2001    FIND\n"
+    "2001    WHERE\n"
+    "2001    GET\n"
+    "2002    RELEA\n"
+    "2002    FREE\n"
+    "2002    DISCA\n"
+    "2002    DROP\n"
+    "2002    DUMP\n"
+    "2003    DUMMY\n"
+    "2004    UNLOC\n"
+    "2004    OPEN\n"
+    "2004    LIFT\n"
+    "2005    NOTHI\n"
+    "2005    HOLD\n"
+    "2006    LOCK\n"
+    "2006    CLOSE\n"
+    "2007    LIGHT\n"
+    "2007    ON\n"
+    "2008    EXTIN\n"
+    "2008    OFF\n"
+    "2009    STRIK\n"
+    "2010    CALM\n"
+    "2010    WAVE\n"
+    "2010    SHAKE\n"
+    "2010    SING\n"
+    "2010    CLEAV\n"
+    "2011    WALK\n"
+    "2011    RUN\n"
+    "2011    TRAVE\n"
+    "2011    GO\n"
+    "2011    PROCE\n"
+    "2011    CONTI\n"
+    "2011    EXPLO\n"
+    "2011    GOTO\n"
+    "2011    FOLLO\n"
+    "2012    ATTAC\n"
+    "2012    KILL\n"
+    "2012    STAB\n"
+    "2012    FIGHT\n"
+    "2012    HIT\n"
+    "2013    POUR\n"
+    "2014    EAT\n"
+    "2015    DRINK\n"
+    "2016    RUB\n"
+    "3050    OPENS\n"
+    "3051    HELP\n"
+    "3051    ?\n"
+    "3051    WHAT\n"
+    "3064    TREE\n"
+    "3066    DIG\n"
+    "3066    EXCIV\n"
+    "3067    BLAST\n"
+    "3068    LOST\n"
+    "3069    MIST\n"
+    "3049    THROW\n"
+    "3079    FUCK\n"
+    "-1\n"
+    "5\n"
+    "201  THERE ARE SOME KEYS ON THE GROUND HERE.\n"
+    "202  THERE IS A SHINY BRASS LAMP NEARBY.\n"
+    "3    THE GRATE IS LOCKED\n"
+    "103  THE GRATE IS OPEN.\n"
+    "204  THERE IS A SMALL WICKER CAGE DISCARDED NEARBY.\n"
+    "205  A THREE FOOT BLACK ROD WITH A RUSTY STAR ON AN END LIES NEARBY\n"
+    "206  ROUGH STONE STEPS LEAD DOWN THE PIT.\n"
+    "7    A CHEERFUL LITTLE BIRD IS SITTING HERE SINGING.\n"
+    "107  THERE IS A LITTLE BIRD IN THE CAGE.\n"
+    "8    THE GRATE IS LOCKED\n"
+    "108  THE GRATE IS OPEN.\n"
+    "209  ROUGH STONE STEPS LEAD UP THE DOME.\n"
+    "210  THERE IS A LARGE SPARKLING NUGGET OF GOLD HERE!\n"
+    "11   A HUGE GREEN FIERCE SNAKE BARS THE WAY!\n"
+    "112  A CRYSTAL BRIDGE NOW SPANS THE FISSURE.\n"
+    "213  THERE ARE DIAMONDS HERE!\n"
+    "214  THERE ARE BARS OF SILVER HERE!\n"
+    "215  THERE IS PRECIOUS JEWELRY HERE!\n"
+    "216  THERE ARE MANY COINS HERE!\n"
+    "19   THERE IS FOOD HERE.\n"
+    "20   THERE IS A BOTTLE OF WATER HERE.\n"
+    "120  THERE IS AN EMPTY BOTTLE HERE.\n"
+    "221  THERE IS A LITTLE AXE HERE\n"
+    "-1\n"
+    "6\n"
+    "1    SOMEWHERE NEARBY IS COLOSSAL CAVE, WHERE OTHERS HAVE FOUND\n"
+    "1    FORTUNES IN TREASURE AND GOLD, THOUGH IT IS RUMORED\n"
+    "1    THAT SOME WHO ENTER ARE NEVER SEEN AGAIN. MAGIC IS SAID\n"
+    "1    TO WORK IN THE CAVE.  I WILL BE YOUR EYES AND HANDS. DIRECT\n"
+    "1    ME WITH COMMANDS OF 1 OR 2 WORDS.\n"
+    "1    (ERRORS, SUGGESTIONS, COMPLAINTS TO CROWTHER)\n"
+    "1    (IF STUCK TYPE HELP FOR SOME HINTS)\n"
+    "2    A LITTLE DWARF WITH A BIG KNIFE BLOCKS YOUR WAY.\n"
+    "3    A LITTLE DWARF JUST WALKED AROUND A CORNER,SAW YOU, THREW\n"
+    "3    A LITTLE AXE AT YOU WHICH MISSED, CURSED, AND RAN AWAY.\n"
+    "4    THERE IS A THREATENING LITTLE DWARF IN THE ROOM WITH YOU!\n"
+    "5    ONE SHARP NASTY KNIFE IS THROWN AT YOU!\n"
+    "6    HE GETS YOU!\n"
+    "7    NONE OF THEM HIT YOU!\n"
+    "8    A HOLLOW VOICE SAYS 'PLUGH'\n"
+    "9    THERE IS NO WAY TO GO THAT DIRECTION.\n"
+    "10   I AM UNSURE HOW YOU ARE FACING. USE COMPASS POINTS OR\n"
+    "10   NEARBY OBJECTS.\n"
+    "11   I DON'T KNOW IN FROM OUT HERE. USE COMPASS POINTS OR NAME\n"
+    "11   SOMETHING IN THE GENERAL DIRECTION YOU WANT TO GO.\n"
+    "12   I DON'T KNOW HOW TO APPLY THAT WORD HERE.\n"
+    "13   I DON'T UNDERSTAND THAT!\n"
+    "14   I ALWAYS UNDERSTAND COMPASS DIRECTIONS, OR YOU CAN NAME\n"
+    "14   A NEARBY THING TO HEAD THAT WAY.\n"
+    "15   SORRY, BUT I AM NOT ALLOWED TO GIVE MORE DETAIL. I WILL\n"
+    "15   REPEAT THE LONG DESCRIPTION OF YOUR LOCATION.\n"
+    "16   IT IS NOW PITCH BLACK. IF YOU PROCEED YOU WILL LIKELY\n"
+    "16   FALL INTO A PIT.\n"
+    "17   IF YOU PREFER, SIMPLY TYPE W RATHER THAN WEST.\n"
+    "18   ARE YOU TRYING TO CATCH THE BIRD?\n"
+    "19   THE BIRD IS FRIGHTENED RIGHT NOW AND YOU CANNOT CATCH IT\n"
+    "19   NO MATTER WHAT YOU TRY. PERHAPS YOU MIGHT TRY LATER.\n"
+    "20   ARE YOU TRYING TO ATTACK OR AVOID THE SNAKE?\n"
+    "21   YOU CAN'T KILL THE SNAKE, OR DRIVE IT AWAY, OR AVOID IT,\n"
+    "21   OR ANYTHING LIKE THAT. THERE IS A WAY TO GET BY, BUT YOU\n"
+    "21   DON'T HAVE THE NECESSARY RESOURCES RIGHT NOW.\n"
+    "22   MY WORD FOR HITTING SOMETHING WITH THE ROD IS 'STRIKE'.\n"
+    "23   YOU FELL INTO A PIT AND BROKE EVERY BONE IN YOUR BODY!\n"
+    "24   YOU ARE ALREADY CARRYING IT!\n"
+    "25   YOU CAN'T BE SERIOUS!\n"
+    "26   THE BIRD WAS UNAFRAID WHEN YOU ENTERED, BUT AS YOU APPROACH\n"
+    "26   IT BECOMES DISTURBED AND YOU CANNOT CATCH IT.\n"
+    "27   YOU CAN CATCH THE BIRD, BUT YOU CANNOT CARRY IT.\n"
+    "28   THERE IS NOTHING HERE WITH A LOCK!\n"
+    "29   YOU AREN'T CARRYING IT!\n"
+    "30   THE LITTLE BIRD ATTACKS THE GREEN SNAKE, AND IN AN\n"
+    "30   ASTOUNDING FLURRY DRIVES THE SNAKE AWAY.\n"
+    "31   YOU HAVE NO KEYS!\n"
+    "32   IT HAS NO LOCK.\n"
+    "33   I DON'T KNOW HOW TO LOCK OR UNLOCK SUCH A THING.\n"
+    "34   THE GRATE WAS ALREADY LOCKED.\n"
+    "35   THE GRATE IS NOW LOCKED.\n"
+    "36   THE GRATE WAS ALREADY UNLOCKED.\n"
+    "37   THE GRATE IS NOW UNLOCKED.\n"
+    "38   YOU HAVE NO SOURCE OF LIGHT.\n"
+    "39   YOUR LAMP IS NOW ON.\n"
+    "40   YOUR LAMP IS NOW OFF.\n"
+    "41   STRIKE WHAT?\n"
+    "42   NOTHING HAPPENS.\n"
+    "43   WHERE?\n"
+    "44   THERE IS NOTHING HERE TO ATTACK.\n"
+    "45   THE LITTLE BIRD IS NOW DEAD. ITS BODY DISAPPEARS.\n"
+    "46   ATTACKING THE SNAKE BOTH DOESN'T WORK AND IS VERY DANGEROUS.\n"
+    "47   YOU KILLED A LITTLE DWARF.\n"
+    "48   YOU ATTACK A LITTLE DWARF, BUT HE DODGES OUT OF THE WAY.\n"
+    "49   I HAVE TROUBLE WITH THE WORD 'THROW' BECAUSE YOU CAN THROW\n"
+    "49   A THING OR THROW AT A THING. PLEASE USE DROP OR ATTACK INSTEAD.\n"
+    "50   GOOD TRY, BUT THAT IS AN OLD WORN-OUT MAGIC WORD.\n"
+    "51   I KNOW OF PLACES, ACTIONS, AND THINGS. MOST OF MY VOCABULARY\n"
+    "51   DESCRIBES PLACES AND IS USED TO MOVE YOU THERE. TO MOVE TRY\n"
+    "51   WORDS LIKE FOREST, BUILDING, DOWNSTREAM, ENTER, EAST, WEST\n"
+    "51   NORTH, SOUTH, UP, OR DOWN.  I KNOW ABOUT A FEW SPECIAL OBJECTS,\n"
+    "51   LIKE A BLACK ROD HIDDEN IN THE CAVE. THESE OBJECTS CAN BE\n"
+    "51   MANIPULATED USING ONE OF THE ACTION WORDS THAT I KNOW. USUALLY \n"
+    "51   YOU WILL NEED TO GIVE BOTH THE OBJECT AND ACTION WORDS\n"
+    "51   (IN EITHER ORDER), BUT SOMETIMES I CAN INFER THE OBJECT FROM\n"
+    "51   THE VERB ALONE. THE OBJECTS HAVE SIDE EFFECTS - FOR\n"
+    "51   INSTANCE, THE ROD SCARES THE BIRD.\n"
+    "51   USUALLY PEOPLE HAVING TROUBLE MOVING JUST NEED TO TRY A FEW\n"
+    "51   MORE WORDS. USUALLY PEOPLE TRYING TO MANIPULATE AN\n"
+    "51   OBJECT ARE ATTEMPTING SOMETHING BEYOND THEIR (OR MY!)\n"
+    "51   CAPABILITIES AND SHOULD TRY A COMPLETELY DIFFERENT TACK.\n"
+    "51   TO SPEED THE GAME YOU CAN SOMETIMES MOVE LONG DISTANCES\n"
+    "51   WITH A SINGLE WORD. FOR EXAMPLE, 'BUILDING' USUALLY GETS\n"
+    "51   YOU TO THE BUILDING FROM ANYWHERE ABOVE GROUND EXCEPT WHEN\n"
+    "51   LOST IN THE FOREST. ALSO, NOTE THAT CAVE PASSAGES TURN A\n"
+    "51   LOT, AND THAT LEAVING A ROOM TO THE NORTH DOES NOT GUARANTEE\n"
+    "51   ENTERING THE NEXT FROM THE SOUTH. GOOD LUCK!\n"
+    "52   IT MISSES!\n"
+    "53   IT GETS YOU!\n"
+    "54   OK\n"
+    "55   YOU CAN'T UNLOCK THE KEYS.\n"
+    "56   YOU HAVE CRAWLED AROUND IN SOME LITTLE HOLES AND WOUND UP\n"
+    "56   BACK IN THE MAIN PASSAGE.\n"
+    "57   I DON'T KNOW WHERE THE CAVE IS, BUT HEREABOUTS NO STREAM\n"
+    "57   CAN RUN ON THE SURFACE FOR LONG. I WOULD TRY THE STREAM.\n"
+    "58   I NEED MORE DETAILED INSTRUCTIONS TO DO THAT.\n"
+    "59   I CAN ONLY TELL YOU WHAT YOU SEE AS YOU MOVE ABOUT\n"
+    "59   AND MANIPULATE THINGS. I CANNOT TELL YOU WHERE REMOTE THINGS\n"
+    "59   ARE.\n"
+    "60   I DON'T KNOW THAT WORD.\n"
+    "61   WHAT?\n"
+    "62   ARE YOU TRYING TO GET INTO THE CAVE?\n"
+    "63   THE GRATE IS VERY SOLID AND HAS A HARDENED STEEL LOCK. YOU\n"
+    "63   CANNOT ENTER WITHOUT A KEY, AND THERE ARE NO KEYS NEARBY.\n"
+    "63   I WOULD RECOMMEND LOOKING ELSEWHERE FOR THE KEYS.\n"
+    "64   THE TREES OF THE FOREST ARE LARGE HARDWOOD OAK AND MAPLE,\n"
+    "64   WITH AN OCCASIONAL GROVE OF PINE OR SPRUCE. THERE IS QUITE\n"
+    "64   A BIT OF UNDERGROWTH, LARGELY BIRCH AND ASH SAPLINGS PLUS\n"
+    "64   NONDESCRITPT BUSHES OF VARIOUS SORTS. THIS TIME OF YEAR\n"
+    "64   VISIBILITY IS QUITE RESTRICTED BY ALL THE LEAVES, BUT TRAVEL\n"
+    "64   IS QUITE EASY IF YOU DETOUR AROUND THE SPRUCE AND BERRY BUSHES.\n"
+    "65   WELCOME TO ADVENTURE!!  WOULD YOU LIKE INSTRUCTIONS?\n"
+    "66   DIGGING WITHOUT A SHOVEL IS QUITE IMPRACTICAL: EVEN WITH A\n"
+    "66   SHOVEL PROGRESS IS UNLIKELY.\n"
+    "67   BLASTING REQUIRES DYNAMITE.\n"
+    "68   I'M AS CONFUSED AS YOU ARE.\n"
+    "69   MIST IS A WHITE VAPOR, USUALLY WATER, SEEN FROM TIME TO TIME\n"
+    "69   IN CAVERNS. IT CAN BE FOUND ANYWHERE BUT IS FREQUENTLY A SIGN\n"
+    "69   OF A DEEP PIT LEADING DOWN TO WATER.\n"
+    "70   YOUR FEET ARE NOW WET.\n"
+    "71   THERE IS NOTHING HERE TO EAT.\n"
+    "72   EATEN!\n"
+    "73   THERE IS NO DRINKABLE WATER HERE.\n"
+    "74   THE BOTTLE OF WATER IS NOW EMPTY.\n"
+    "75   RUBBING THE ELECTRIC LAMP IS NOT PARTICULARLY REWARDING.\n"
+    "75   ANYWAY, NOTHING EXCITING HAPPENS.\n"
+    "76   PECULIAR.  NOTHING UNEXPECTED HAPPENS.\n"
+    "77   YOUR BOTTLE IS EMPTY AND THE GROUND IS WET.\n"
+    "78   YOU CAN'T POUR THAT.\n"
+    "79   WATCH IT!\n"
+    "80   WHICH WAY?\n"
+    "-1\n"
+    "0\n"
+};
+
 
-// The contents of the text file http://www.icynic.com/~don/jerz/advdat.77-03-31
-const std::string advdat_77_03_31{
+// The contents of the text file http://www.icynic.com/~don/jerz/advdat.77-03-11
+// [The earlier revision of the data file. It differs from advdat_77_03_31 in
+// a blank line after the text for location 30, which the loader skips, and
+// in the message numbers of the keywords OPENS..FUCK (3001..3009 rather than
+// 3049..3079).]
+const std::string advdat_77_03_11{
     "1\n"
     "1    YOU ARE STANDING AT THE END OF A ROAD BEFORE A SMALL BRICK\n"
     "1    BUILDING . AROUND YOU IS A FOREST. A SMALL\n"
@@ -1697,6 +6124,7 @@ const std::string advdat_77_03_31{
     "29   YOU ARE IN THE SOUTH SIDE CHAMBER.\n"
     "30   YOU ARE IN THE WEST SIDE CHAMBER OF HALL OF MT KING.\n"
     "30   A PASSAGE CONTINUES WEST AND UP HERE.\n"
+    "\n"
     "31   THERE IS NO WAY ACROSS THE FISSURE.\n"
     "32   YOU CAN'T GET BY THE SNAKE\n"
     "33   YOU ARE IN A LARGE ROOM, WITH A PASSAGE TO THE SOUTH,\n"
@@ -2198,18 +6626,18 @@ const std::string advdat_77_03_31{
     "2014    EAT\n"
     "2015    DRINK\n"
     "2016    RUB\n"
-    "3050    OPENS\n"
-    "3051    HELP\n"
-    "3051    ?\n"
-    "3051    WHAT\n"
-    "3064    TREE\n"
-    "3066    DIG\n"
-    "3066    EXCIV\n"
-    "3067    BLAST\n"
-    "3068    LOST\n"
-    "3069    MIST\n"
-    "3049    THROW\n"
-    "3079    FUCK\n"
+    "3001    OPENS\n"
+    "3002    HELP\n"
+    "3002    ?\n"
+    "3002    WHAT\n"
+    "3003    TREE\n"
+    "3004    DIG\n"
+    "3004    EXCIV\n"
+    "3005    BLAST\n"
+    "3006    LOST\n"
+    "3007    MIST\n"
+    "3008    THROW\n"
+    "3009    FUCK\n"
     "-1\n"
     "5\n"
     "201  THERE ARE SOME KEYS ON THE GROUND HERE.\n"
@@ -2374,6 +6802,682 @@ const std::string advdat_77_03_31{
 };
 
 
+// [Not part of Crowther's code. Return the tables loaded from the given
+//  compiled-in data file text.]
+shared_world load_compiled_world(std::string_view text)
+{
+    // (the loader only asks for input if the data file is too big)
+    class advent_io_loader : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return "X"; }
+        void type(const std::string &) override {}
+        void type(int) override {}
+    };
+
+    scaffolding::text_view_stream advdat(text);
+    advent_io_loader io;
+    return load_world(advdat, io);
+}
+
+// Return the tables loaded from advdat_77_03_31. [Not part of Crowther's code.
+// The text is parsed on the first call only; every call returns the same world.]
+shared_world advdat_77_03_31_world()
+{
+    static const shared_world w = load_compiled_world(advdat_77_03_31);
+    return w;
+}
+
+// [Not part of Crowther's code. As above, for advdat_77_03_11.]
+shared_world advdat_77_03_11_world()
+{
+    static const shared_world w = load_compiled_world(advdat_77_03_11);
+    return w;
+}
+
+
+// [Not part of Crowther's code. The data file revisions compiled in, newest
+//  first. Each revision's tables are loaded on first use, once per process,
+//  and shared by every session played with them.]
+struct compiled_data_file {
+    const char * revision;          // [e.g. "77-03-31"]
+    shared_world (*tables)();
+};
+
+constexpr compiled_data_file compiled_data_files[] = {
+    {"77-03-31", advdat_77_03_31_world},
+    {"77-03-11", advdat_77_03_11_world},
+};
+
+// [Not part of Crowther's code. Return the tables of the given compiled-in
+//  data file revision, or null if there is no such revision.]
+shared_world compiled_world(std::string_view revision)
+{
+    for (const auto & data : compiled_data_files) {
+        if (revision == data.revision)
+            return data.tables();
+    }
+    return nullptr;
+}
+
+
+DEF_TEST_FUNC(load_profile)
+{
+    class advent_io_loader : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return "X"; }
+        void type(const std::string &) override {}
+        void type(int) override {}
+    };
+    advent_io_loader io;
+
+    // every allocation is counted, if they are counted at all
+    const size_t before = scaffolding::allocation_count.load();
+    auto p = std::make_unique<int>(1);
+    TEST_EQUAL(scaffolding::allocation_count.load() - before, scaffolding::counting_allocations ? 1U : 0U);
+
+    // a profile adds up the loads given it; the same tables are loaded
+    load_profile in_place, streamed;
+    for (int n = 0; n < 2; ++n) {
+        scaffolding::text_view_stream advdat(advdat_77_03_31);
+        TEST_EQUAL(load_world(advdat, io, &in_place)->fingerprint, advdat_77_03_31_world()->fingerprint);
+    }
+    std::istringstream iss(advdat_77_03_31);
+    load_world(iss, io, &streamed);
+    TEST_EQUAL(in_place.loads, 2U);
+    TEST_EQUAL(streamed.loads, 1U);
+    uint_least64_t nanoseconds = 0;
+    for (const auto t : in_place.nanoseconds)
+        nanoseconds += t;
+    TEST_EQUAL(nanoseconds > 0, true);
+
+    // parsing in place reads the text without allocating; a stream doesn't
+    TEST_EQUAL(in_place.allocations[load_profile::text], 0U);
+    TEST_EQUAL(in_place.allocations[load_profile::map], 0U);
+    TEST_EQUAL(in_place.allocations[load_profile::keywords], 0U);
+    TEST_EQUAL(streamed.allocations[load_profile::text] > 0, scaffolding::counting_allocations);
+}
+
+
+DEF_TEST_FUNC(load_world_file)
+{
+    class advent_io_loader : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return "X"; }
+        void type(const std::string &) override {}
+        void type(int) override {}
+    };
+    advent_io_loader io;
+    const uint_least64_t fingerprint = advdat_77_03_31_world()->fingerprint;
+
+    // parsing the text in place gives the same tables as reading it from a stream
+    scaffolding::text_view_stream advdat(advdat_77_03_31);
+    TEST_EQUAL(load_world(advdat, io)->fingerprint, fingerprint);
+
+    // as does a data file with DOS line endings
+    std::string dos;
+    for (const char c : advdat_77_03_31)
+        dos += c == '\n' ? "\r\n" : std::string(1, c);
+    const std::string path = (std::filesystem::temp_directory_path() / "advent-test-advdat.txt").string();
+    {
+        std::ofstream os(path, std::ios::binary);
+        os << dos;
+    }
+    TEST_EQUAL(load_world_file(path, io)->fingerprint, fingerprint);
+    std::remove(path.c_str());
+
+    // as do the data files in doc/, which have a tab after each number
+    // (if this source is where it was compiled from, with doc/ beside it)
+    const auto doc = std::filesystem::path(__FILE__).parent_path().parent_path() / "doc";
+    if (std::filesystem::exists(doc / "advdat.77-03-31.txt")) {
+        TEST_EQUAL(load_world_file((doc / "advdat.77-03-31.txt").string(), io)->fingerprint, fingerprint);
+        TEST_EQUAL(load_world_file((doc / "advdat.77-03-11.txt").string(), io)->fingerprint,
+            advdat_77_03_11_world()->fingerprint);
+    }
+
+    std::string_view text = " \n -12+3 x";
+    int n = 0;
+    TEST_EQUAL(scaffolding::read_int(text, n), true);
+    TEST_EQUAL(n, -12);
+    TEST_EQUAL(scaffolding::read_int(text, n), true);
+    TEST_EQUAL(n, 3);
+    TEST_EQUAL(scaffolding::read_int(text, n), false);
+    TEST_EQUAL(text, " x");
+
+    bool thrown = false;
+    try {
+        load_world_file(path + ".missing", io);
+    }
+    catch (const scaffolding::adventure_exception &) {
+        thrown = true;
+    }
+    TEST_EQUAL(thrown, true);
+}
+
+DEF_BENCH_FUNC(load_world)
+{
+    class advent_io_loader : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return "X"; }
+        void type(const std::string &) override {}
+        void type(int) override {}
+    };
+    advent_io_loader io;
+
+    BENCHMARK("load_world(std::istringstream)", 100, [&] {
+        std::istringstream iss(advdat_77_03_31);
+        return load_world(iss, io)->fingerprint;
+    });
+    BENCHMARK("load_world(text_view_stream)", 100, [&] {
+        scaffolding::text_view_stream advdat(advdat_77_03_31);
+        return load_world(advdat, io)->fingerprint;
+    });
+}
+
+
+// [The cold start: the time taken by, and the allocations made in, each
+//  stage of loading the tables, from the built-in text through a stream
+//  and in place, and from a mapped data file; reading a world image
+//  instead; and the object setup at labels 1100..1104 when a game starts.
+//  The allocations are reported only by builds that count them.]
+DEF_BENCH_FUNC(load_stages)
+{
+    class advent_io_loader : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return "X"; }
+        void type(const std::string &) override {}
+        void type(int) override {}
+    };
+    advent_io_loader io;
+    constexpr int loads = 100;
+
+    auto report = [](const std::string & name, size_t n, uint_least64_t nanoseconds, size_t allocations) {
+        std::cout << "load_stages " << name << ": " << nanoseconds / n << " ns";
+        if (scaffolding::counting_allocations)
+            std::cout << ", " << static_cast<double>(allocations) / n << " allocations";
+        std::cout << '\n';
+    };
+    auto report_profile = [&](const std::string & name, const load_profile & profile) {
+        uint_least64_t nanoseconds = 0;
+        size_t allocations = 0;
+        for (int s = 0; s < load_profile::stages; ++s) {
+            report(name + " " + load_profile::stage_names[s], profile.loads,
+                profile.nanoseconds[s], profile.allocations[s]);
+            nanoseconds += profile.nanoseconds[s];
+            allocations += profile.allocations[s];
+        }
+        report(name + " total", profile.loads, nanoseconds, allocations);
+    };
+    // (time and count the allocations of f() called loads times)
+    auto measure = [&](const std::string & name, auto f) {
+        const size_t allocations = scaffolding::allocation_count.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < loads; ++n)
+            f();
+        const auto stop = std::chrono::steady_clock::now();
+        report(name, loads, static_cast<uint_least64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()),
+            scaffolding::allocation_count.load() - allocations);
+    };
+
+    load_profile streamed;
+    measure("std::istringstream (all)", [&] {
+        std::istringstream iss(advdat_77_03_31);
+        load_world(iss, io, &streamed);
+    });
+    report_profile("std::istringstream", streamed);
+
+    load_profile in_place;
+    measure("text_view_stream (all)", [&] {
+        scaffolding::text_view_stream advdat(advdat_77_03_31);
+        load_world(advdat, io, &in_place);
+    });
+    report_profile("text_view_stream", in_place);
+
+    const auto temp = std::filesystem::temp_directory_path();
+    const std::string data_path = (temp / "advent-bench-advdat.txt").string();
+    const std::string image_path = (temp / "advent-bench-advdat.img").string();
+    {
+        std::ofstream os(data_path, std::ios::binary);
+        os << advdat_77_03_31;
+        std::ofstream image(image_path, std::ios::binary);
+        write_image(image, *advdat_77_03_31_world());
+    }
+    load_profile mapped;
+    measure("mapped file (all)", [&] {
+        load_world_file(data_path, io, &mapped);
+    });
+    report_profile("mapped file", mapped);
+
+    measure("world image", [&] {
+        auto w = std::make_shared<world>();
+        std::ifstream is(image_path, std::ios::binary);
+        read_image(is, *w);
+    });
+    std::remove(data_path.c_str());
+    std::remove(image_path.c_str());
+
+    const shared_world w = advdat_77_03_31_world();
+    measure("session::start (1100..INIT DONE)", [&] {
+        session s(w);
+        s.start();
+    });
+}
+
+DEF_TEST_FUNC(world)
+{
+    const world & w = *advdat_77_03_31_world();
+    TEST_EQUAL(&w == advdat_77_03_31_world().get(), true);
+
+    // a few values that can be checked by eye against advdat_77_03_31
+    TEST_EQUAL(w.ltext[1], 1);
+    TEST_EQUAL(w.lline[1][1], 2);       // (line 1 continues on line 2)
+    TEST_EQUAL(w.lline[3][1], 0);       // (line 3 is the last line of ltext[1])
+    TEST_EQUAL(w.lline[3][2], 12);      // (last non-blank word of line 3)
+    TEST_EQUAL(w.lline[3][3], scaffolding::as_a5("STREA"));
+    TEST_EQUAL(w.key[1], 1);
+    TEST_EQUAL(w.travel[1], 2 * 1024 + 2);
+    TEST_EQUAL(w.travel[2], 2 * 1024 + 44);
+    TEST_EQUAL(w.travel[16], -(8 * 1024 + 49)); // (last entry for location 1)
+    TEST_EQUAL(w.ktab[1], 2);
+    TEST_EQUAL(w.atab[1], scaffolding::as_a5("ROAD"));
+    TEST_EQUAL(w.cond[1], 1);
+    TEST_EQUAL(w.cond[16], 2);
+    TEST_EQUAL(w.cond[17], 0);
+
+    // the image of a world must be the same world
+    std::stringstream image;
+    write_image(image, w);
+    auto restored = std::make_unique<world>();
+    read_image(image, *restored);
+    TEST_EQUAL(*restored == w, true);
+
+    // an image written by an incompatible build must be rejected
+    std::string buf{image.str()};
+    buf[sizeof(world_image_magic)] ^= 1; // (corrupt the version number)
+    std::istringstream bad_image(buf);
+    bool rejected = false;
+    try {
+        read_image(bad_image, *restored);
+    }
+    catch (const scaffolding::adventure_exception &) {
+        rejected = true;
+    }
+    TEST_EQUAL(rejected, true);
+}
+
+
+DEF_TEST_FUNC(shared_world)
+{
+#if ADVENT_HAVE_MMAP
+    const shared_world & w = advdat_77_03_31_world();
+    const std::string name = "advent-test-" + std::to_string(::getpid());
+
+    // an attached world is the published world, but not a copy of it
+    publish_shared_world(name, *w);
+    const shared_world first = attach_shared_world(name), second = attach_shared_world(name);
+    TEST_EQUAL(*first == *w, true);
+    TEST_EQUAL(first.get() != w.get() && first.get() != second.get(), true);
+    TEST_EQUAL(reinterpret_cast<uintptr_t>(first.get()) % alignof(world), 0U);
+
+    // which may be played
+    class advent_io_collect : public scaffolding::advent_io {
+    public:
+        std::string output;
+        std::string getline() override { return {}; }
+        void type(const std::string & msg) override { output += msg; }
+        void type(int n) override { output += std::to_string(n); }
+    };
+    advent_io_collect io;
+    session s(first);
+    s.start(io);
+    s.step("G", io);  // (INIT DONE)
+    s.step("NO", io); // (no instructions)
+    TEST_EQUAL(io.output.find("END OF A ROAD") != std::string::npos, true);
+
+    // once the name is removed it can't be attached, but is still mapped
+    unlink_shared_world(name);
+    bool rejected = false;
+    try {
+        attach_shared_world(name);
+    }
+    catch (const scaffolding::adventure_exception &) {
+        rejected = true;
+    }
+    TEST_EQUAL(rejected, true);
+    TEST_EQUAL(second->fingerprint, w->fingerprint);
+#endif
+}
+
+
+DEF_TEST_FUNC(compiled_world)
+{
+    const shared_world w = compiled_world("77-03-31"), old = compiled_world("77-03-11");
+    TEST_EQUAL(w == advdat_77_03_31_world(), true);
+    TEST_EQUAL(old == advdat_77_03_11_world() && old != w, true);
+    TEST_EQUAL(compiled_world("77-03-23") == nullptr, true);
+
+    // the revisions differ only in the keyword message numbers
+    TEST_EQUAL(old->fingerprint != w->fingerprint, true);
+    TEST_EQUAL(old->ltext == w->ltext && old->lline == w->lline && old->travel == w->travel, true);
+    const int opens = find_word(*old, scaffolding::as_a5("OPENS"));
+    TEST_EQUAL(old->ktab[opens], 3001);
+    TEST_EQUAL(w->ktab[opens], 3050);
+    int differ = 0;
+    for (int i = 1; i <= 1000; ++i)
+        differ += old->ktab[i] != w->ktab[i];
+    TEST_EQUAL(differ, 12);
+
+    // games on the two revisions may be played side by side
+    session s(w), t(old);
+    s.step("g");
+    t.step("g");
+    TEST_EQUAL(s.step("no"), t.step("no"));
+    TEST_EQUAL(s.step("mist").find("MIST IS A WHITE VAPOR") != std::string::npos, true);
+    TEST_EQUAL(t.step("mist").find("MIST IS A WHITE VAPOR") != std::string::npos, false);
+}
+
+
+// [the loop at label 2023, as Crowther wrote it]
+int find_word_by_scan(const world & w, uint_least64_t a)
+{
+    int i;
+    for (i = 1; i <= 1000; ++i) {
+        if (w.ktab[i] == -1) break;
+        if (w.atab[i] == a) break;
+    }
+    return i;
+}
+
+DEF_TEST_FUNC(find_word)
+{
+    const world & w = *advdat_77_03_31_world();
+    TEST_EQUAL(w.vocab_end > 1 && w.vocab_end <= 1000, true);
+    TEST_EQUAL(w.ktab[w.vocab_end], -1);
+    TEST_EQUAL(w.vocab_size > 0 && w.vocab_size < w.vocab_end, true);
+
+    // every keyword must be found where the scan would find it; some words
+    // appear more than once, in which case the first must be the one found
+    for (int i = 1; i < w.vocab_end; ++i)
+        TEST_EQUAL(find_word(w, w.atab[i]), find_word_by_scan(w, w.atab[i]));
+    TEST_EQUAL(find_word(w, scaffolding::as_a5("ROAD")), 1);
+    TEST_EQUAL(find_word(w, scaffolding::as_a5("XYZZY")), find_word_by_scan(w, scaffolding::as_a5("XYZZY")));
+
+    // words not in the vocabulary must lead to the end marker
+    for (const char * word : {"", "A", "ZZZZZ", "FRED", "ROA", "ROADS"})
+        TEST_EQUAL(find_word(w, scaffolding::as_a5(word)), w.vocab_end);
+
+    // without an end marker an unknown word must run off the end of the table
+    auto full = std::make_unique<world>(w);
+    for (int i = w.vocab_end; i <= 1000; ++i) {
+        full->ktab[i] = 1000 + i;
+        full->atab[i] = scaffolding::as_a5(std::to_string(i));
+    }
+    index_vocabulary(*full);
+    TEST_EQUAL(full->vocab_end, 1001);
+    TEST_EQUAL(find_word(*full, scaffolding::as_a5("FRED")), 1001);
+    TEST_EQUAL(find_word(*full, scaffolding::as_a5("1000")), 1000);
+}
+
+DEF_TEST_FUNC(travel_index)
+{
+    const world & w = *advdat_77_03_31_world();
+
+    // the index must give the outcome of the walk for every location and motion
+    int matches = 0, misses = 0;
+    for (int loc = 1; loc <= 300; ++loc) {
+        for (int k = 0; k < world::travel_motions; ++k) {
+            if (w.key[loc] == 0) {
+                TEST_EQUAL(w.travel_index[loc][k], 0);
+                continue;
+            }
+            TEST_EQUAL(w.travel_index[loc][k], walk_travel(w, w.key[loc], k));
+            if (w.travel_index[loc][k] > 0)
+                ++matches;
+            else
+                ++misses;
+        }
+    }
+    TEST_EQUAL(matches > 0 && misses > 0, true);
+
+    // at location 1, WEST (44) leads to location 2
+    const int kk = w.travel_index[1][44];
+    TEST_EQUAL(kk > 0 && std::abs(w.travel[kk]) / 1024 == 2, true);
+    TEST_EQUAL(w.travel_index[1][45], walk_travel(w, w.key[1], 45)); // (north)
+}
+
+
+DEF_TEST_FUNC(pack_tables)
+{
+    const world & w = *advdat_77_03_31_world();
+    static_assert(sizeof(w.travel_packed) + sizeof(w.ktab_packed) <= 8 * 1024);
+
+    // every entry must unpack to what the division and modulus would give
+    for (int kk = 0; kk <= 1000; ++kk) {
+        const int ll = std::abs(w.travel[kk]);
+        TEST_EQUAL(w.travel_packed[kk].to, ll / 1024);
+        TEST_EQUAL(w.travel_packed[kk].motion, ll % 1024);
+        TEST_EQUAL(w.travel_packed[kk].last, w.travel[kk] < 0);
+        TEST_EQUAL(w.ktab_packed[kk].value, w.ktab[kk] % 1000);
+        TEST_EQUAL(w.ktab_packed[kk].type, w.ktab[kk] / 1000);
+    }
+
+    // at location 1, WEST (44) leads to location 2
+    TEST_EQUAL(w.travel_packed[w.travel_index[1][44]].to, 2);
+
+    // values that don't fit are refused rather than truncated
+    auto refused = [&](int kk, int travel, int ktab) {
+        auto big = std::make_unique<world>(w);
+        big->travel[kk] = travel;
+        big->ktab[kk] = ktab;
+        try {
+            pack_tables(*big);
+        }
+        catch (const scaffolding::adventure_exception &) {
+            return true;
+        }
+        return false;
+    };
+    TEST_EQUAL(refused(1, w.travel[1], w.ktab[1]), false);
+    TEST_EQUAL(refused(1, -70000 * 1024 - 1, w.ktab[1]), true);
+    TEST_EQUAL(refused(1, w.travel[1], 200001), true);
+}
+
+
+DEF_TEST_FUNC(map_paths)
+{
+    const world & w = *advdat_77_03_31_world();
+    const map_graph g = build_map_graph(w);
+
+    // every motion the travel index finds must be an edge of the graph
+    for (int loc = 1; loc <= 300; ++loc) {
+        for (int k = 2; k < world::travel_motions; ++k) {
+            const int kk = w.travel_index[loc][k];
+            if (kk <= 0 || std::abs(w.travel[kk]) / 1024 >= 300)
+                continue;
+            const int to = std::abs(w.travel[kk]) / 1024, motion = std::abs(w.travel[kk]) % 1024;
+            bool found = false;
+            for (int e = g.first[loc]; e < g.first[loc + 1]; ++e)
+                found = found || (g.edges[e].to == to && g.edges[e].motion == motion);
+            TEST_EQUAL(found, true);
+        }
+    }
+
+    const map_paths paths(g, true, 3);
+    TEST_EQUAL(paths.distance(1, 1), 0);
+    TEST_EQUAL(paths.distance(1, 3), 1);                // [road to building]
+    TEST_EQUAL(paths.distance(3, 1), 1);
+    TEST_EQUAL(paths.distance(1, 0), map_paths::unreachable);
+
+    // the route to the Hall of the Mountain King must follow the map
+    const auto route = paths.path(1, 19);
+    TEST_EQUAL(route.size(), static_cast<size_t>(paths.distance(1, 19)));
+    TEST_EQUAL(route.empty(), false);
+    int at = 1;
+    for (const map_edge & step : route) {
+        bool found = false;
+        for (int e = g.first[at]; e < g.first[at + 1]; ++e)
+            found = found || (g.edges[e].to == step.to && g.edges[e].motion == step.motion);
+        TEST_EQUAL(found, true);
+        at = step.to;
+    }
+    TEST_EQUAL(at, 19);
+    const map_paths surface(g, false, 1);
+    TEST_EQUAL(surface.distance(1, 3), 1);
+    TEST_EQUAL(surface.distance(1, 19), paths.distance(1, 19)); // [by the magic words]
+    TEST_EQUAL(surface.reachable(1, 23), false);                // [only by the special transition at the grate]
+    TEST_EQUAL(paths.path(1, 23).back().special, 301);
+
+    // the result doesn't depend on the number of threads
+    const map_paths one(g, true, 1);
+    for (int from = 1; from <= 300; ++from)
+        for (int to = 1; to <= 300; ++to)
+            if (one.distance(from, to) != paths.distance(from, to))
+                TEST_EQUAL(one.distance(from, to), paths.distance(from, to));
+
+    TEST_EQUAL(motion_word(w, 44), "WEST");
+    TEST_EQUAL(motion_word(w, 1), "*");
+}
+
+DEF_BENCH_FUNC(map_paths)
+{
+    const map_graph g = build_map_graph(*advdat_77_03_31_world());
+    BENCHMARK("map_paths(all pairs)", 100, [&] {
+        return map_paths(g).distance(1, 19);
+    });
+    const map_paths paths(g);
+    int n = 0;
+    BENCHMARK("map_paths::path()", 100000, [&] {
+        ++n;
+        return paths.path(1 + n % 79, 1 + n / 79 % 79).size();
+    });
+}
+
+DEF_TEST_FUNC(message_text)
+{
+    const world & w = *advdat_77_03_31_world();
+
+    // record output, counting the strings that had to be copied to std::string
+    class advent_io_text_test : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return {}; }
+        void type(const std::string & msg) override { output += msg; ++copies; }
+        void type(std::string_view msg) override { output += msg; }
+        void type(int n) override { output += std::to_string(n); }
+
+        std::string output;
+        int copies = 0;
+    };
+
+    // every line must be rendered just as type_20a5() types it
+    for (int kk = 0; kk <= 1000; ++kk) {
+        advent_io_text_test expected;
+        scaffolding::type_20a5(expected, w.lline[kk], 3, w.lline[kk][2]);
+        TEST_EQUAL(std::string(line_text(w, kk)), expected.output);
+    }
+
+    // and every message typed as the loops at labels 4 and 2005 type it
+    for (int kk = 1; kk < 1000; ++kk) {
+        advent_io_text_test expected;
+        int k = kk;
+        do
+            scaffolding::type_20a5(expected, w.lline[k], 3, w.lline[k][2]);
+        while (w.lline[k++][1] != 0);
+        expected.output += '\n';
+        TEST_EQUAL(std::string(message_block(w, kk)), expected.output);
+        TEST_EQUAL(w.message_last[kk] + 1, k);
+    }
+
+    // and every message must be spoken just as Crowther's SPEAK speaks it
+    for (int it = 1; it <= 100; ++it) {
+        advent_io_text_test expected, io;
+        speak(expected, w.rtext, w.lline, it);
+        speak(io, w, it);
+        TEST_EQUAL(io.output, expected.output);
+        TEST_EQUAL(io.copies, 0);
+    }
+    advent_io_text_test io;
+    speak(io, w, 3); // [3:"A LITTLE DWARF JUST WALKED AROUND A CORNER,..."] (two lines)
+    TEST_EQUAL(io.output.find("A LITTLE DWARF JUST WALKED AROUND A CORNER,SAW YOU"), 0);
+    TEST_EQUAL(io.output.find("\nA LITTLE AXE AT YOU WHICH MISSED, CURSED, AND RAN AWAY.\n\n"), 60);
+}
+
+DEF_BENCH_FUNC(find_word)
+{
+    const world & w = *advdat_77_03_31_world();
+    std::vector<uint_least64_t> words;
+    for (int i = 1; i < w.vocab_end; ++i)
+        words.push_back(w.atab[i]);
+    words.push_back(scaffolding::as_a5("FRED")); // (unknown words are the worst case for the scan)
+    size_t n = 0;
+    BENCHMARK("find_word_by_scan", 1000000, [&] {
+        return find_word_by_scan(w, words[n++ % words.size()]);
+    });
+    n = 0;
+    BENCHMARK("find_word", 1000000, [&] {
+        return find_word(w, words[n++ % words.size()]);
+    });
+}
+
+DEF_BENCH_FUNC(travel_index)
+{
+    const world & w = *advdat_77_03_31_world();
+    std::vector<std::pair<int, int>> moves; // (location, motion)
+    for (int loc = 1; loc <= 300; ++loc) {
+        if (w.key[loc] != 0) {
+            for (int k : {1, 29, 30, 43, 44, 45, 46})
+                moves.emplace_back(loc, k);
+        }
+    }
+    size_t n = 0;
+    BENCHMARK("walk_travel", 1000000, [&] {
+        const auto & move = moves[n++ % moves.size()];
+        return walk_travel(w, w.key[move.first], move.second);
+    });
+    n = 0;
+    BENCHMARK("travel_index", 1000000, [&] {
+        const auto & move = moves[n++ % moves.size()];
+        return w.travel_index[move.first][move.second];
+    });
+    n = 0;
+    BENCHMARK("walk travel_packed", 1000000, [&] {
+        const auto & move = moves[n++ % moves.size()];
+        int kk = w.key[move.first];
+        for (; kk >= 1 && kk <= 1000; ++kk) {
+            const travel_entry & entry = w.travel_packed[kk];
+            if (entry.motion == 1 || entry.motion == move.second)
+                return kk;
+            if (entry.last)
+                return -kk;
+        }
+        return 0;
+    });
+}
+
+DEF_BENCH_FUNC(speak)
+{
+    const world & w = *advdat_77_03_31_world();
+    class advent_io_null : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return {}; }
+        void type(const std::string & msg) override { size += msg.size(); }
+        void type(std::string_view msg) override { size += msg.size(); }
+        void type(int) override {}
+
+        size_t size = 0;
+    } io;
+    int it = 0;
+    BENCHMARK("speak(rtext, lline)", 100000, [&] {
+        speak(io, w.rtext, w.lline, 1 + it++ % 100);
+        return io.size;
+    });
+    it = 0;
+    BENCHMARK("speak(world)", 100000, [&] {
+        speak(io, w, 1 + it++ % 100);
+        return io.size;
+    });
+}
+
+
 
 DEF_TEST_FUNC(adventure)
 {
@@ -2447,7 +7551,7 @@ DEF_TEST_FUNC(adventure)
             }
         }
 
-        double ran(int call_site) override
+        double ran(int call_site, scaffolding::prng &) override
         {
             if (show_test_output_)
                 std::cout << "ran(" << call_site << ")\n";
@@ -2706,14 +7810,1059 @@ DEF_TEST_FUNC(adventure)
     catch (const done &) {}
 }
 
+
+DEF_TEST_FUNC(location_objects)
+{
+    // the lists must keep the order of Crowther's IOBJ and ICHAIN chains,
+    // here built and walked as at labels 1104..1106, 2003..2008, 5160 and
+    // 9005..9008, through any mix of takes and drops
+    std::array<int, 301> iobj{};
+    std::array<int, 101> ichain{};
+    auto chain = [&](int loc) {
+        std::vector<int> objs;
+        for (int i = iobj[loc]; i != 0; i = ichain[i])
+            objs.push_back(i);
+        return objs;
+    };
+    auto listed = [](const location_objects & lists, int loc) {
+        const auto here = lists.at(loc);
+        return std::vector<int>(here.begin(), here.end());
+    };
+    location_objects lists;
+    std::mt19937 random(1977);
+    std::array<int, 101> place{};
+    for (int i = 1; i <= 100; ++i) {
+        const int loc = static_cast<int>(random() % 5) + 1;
+        place[i] = loc;
+        int ktem = loc;
+        if (iobj[ktem] == 0)
+            iobj[ktem] = i;
+        else {
+            for (ktem = iobj[ktem]; ichain[ktem] != 0; ktem = ichain[ktem])
+                ;
+            ichain[ktem] = i;
+        }
+        lists.push_back(loc, i);
+    }
+    bool same = true;
+    for (int n = 0; n < 2000; ++n) {
+        const int jobj = static_cast<int>(random() % 100) + 1;
+        if (place[jobj] > 0) {
+            const int j = place[jobj];
+            if (iobj[j] == jobj)
+                iobj[j] = ichain[jobj];
+            else {
+                int itemp = iobj[j];
+                while (ichain[itemp] != jobj)
+                    itemp = ichain[itemp];
+                ichain[itemp] = ichain[jobj];
+            }
+            lists.erase(j, jobj);
+            place[jobj] = -1;
+        }
+        else {
+            const int j = static_cast<int>(random() % 5) + 1;
+            ichain[jobj] = iobj[j];
+            iobj[j] = jobj;
+            lists.push_front(j, jobj);
+            place[jobj] = j;
+        }
+        for (int loc = 0; loc <= 6; ++loc)
+            same = same && listed(lists, loc) == chain(loc);
+    }
+    TEST_EQUAL(same, true);
+
+    // an object not in a list can't be taken out of it, and each list may
+    // be restored from the objects and their counts
+    location_objects copy;
+    copy.assign(lists.all(), std::array<uint_least8_t, 5>{
+        static_cast<uint_least8_t>(lists.at(1).size()), static_cast<uint_least8_t>(lists.at(2).size()),
+        static_cast<uint_least8_t>(lists.at(3).size()), static_cast<uint_least8_t>(lists.at(4).size()),
+        static_cast<uint_least8_t>(lists.at(5).size())});
+    for (int loc = 0; loc <= 6; ++loc)
+        TEST_EQUAL(listed(copy, loc) == listed(lists, loc), true);
+    bool threw = false;
+    try {
+        lists.erase(6, 1);
+    }
+    catch (const scaffolding::adventure_exception &) {
+        threw = true;
+    }
+    TEST_EQUAL(threw, true);
+
+    // in a game, a room's objects are listed in chain order: the last
+    // dropped first, then those that were there to begin with
+    session s(advdat_77_03_31_world());
+    s.start();
+    for (const char * command : {"g", "no", "in", "get keys", "get food", "drop keys", "drop food", "get bottle"})
+        s.step(command);
+    const std::string room = s.step("look");
+    TEST_EQUAL(room.find("FOOD") < room.find("KEYS"), true);
+    TEST_EQUAL(room.find("KEYS") < room.find("LAMP"), true);
+    TEST_EQUAL(room.find("BOTTLE"), std::string::npos);
+}
+
+
+DEF_TEST_FUNC(session)
+{
+    struct done : public std::runtime_error {
+        done() : std::runtime_error("done") {}
+    };
+
+    // record all output; supply input from the given list of commands
+    class advent_io_test_session : public scaffolding::advent_io {
+    public:
+        explicit advent_io_test_session(const std::vector<std::string> & commands)
+        : commands_(commands) {}
+
+        std::string getline() override
+        {
+            if (index_ == commands_.size())
+                throw done();
+            return commands_[index_++];
+        }
+
+        void type(const std::string & msg) override { output += msg; }
+        void type(std::string_view msg) override { output += msg; }
+        void type(int n) override { output += std::to_string(n); }
+        double ran(int, scaffolding::prng &) override { return 0.1; } // (no dwarves, no pitfalls)
+
+        std::string output;
+
+    private:
+        const std::vector<std::string> & commands_;
+        size_t index_ = 0;
+    };
+
+    const std::vector<std::string> commands = {
+        "g", "no", "in", "get lamp", "xyzzy", "light lamp", "pit", "down",
+        "south", "get gold", "hall", "y2", "plugh", "west", "g", "fred"
+    };
+
+    // the expected output is that of a game played from start to finish
+    advent_io_test_session expected(commands);
+    try {
+        adventure(advdat_77_03_31_world(), expected);
+    }
+    catch (const done &) {}
+
+    // play two games at once, one command at a time each
+    session s1(advdat_77_03_31_world());
+    session s2(advdat_77_03_31_world());
+    advent_io_test_session io1(commands);
+    advent_io_test_session io2(commands);
+    s1.start(io1);
+    s2.start(io2);
+    for (const auto & command : commands) {
+        s1.step(command, io1);
+        s2.step(command, io2);
+    }
+    TEST_EQUAL(io1.output, expected.output);
+    TEST_EQUAL(io2.output, expected.output);
+
+    // the game must be the same whether or not travel is indexed
+    session_options unindexed;
+    unindexed.travel_index = false;
+    session s5(advdat_77_03_31_world(), unindexed);
+    advent_io_test_session io5(commands);
+    s5.start(io5);
+    for (const auto & command : commands)
+        s5.step(command, io5);
+    TEST_EQUAL(io5.output, expected.output);
+
+    // games with the same seed must be the same when each uses its own generator
+    class advent_io_own_prng : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return {}; }
+        void type(const std::string & msg) override { output += msg; }
+        void type(int n) override { output += std::to_string(n); }
+        std::string output;
+    };
+    session_options seeded;
+    seeded.seed = 12345;
+    session s6(advdat_77_03_31_world(), seeded), s7(advdat_77_03_31_world(), seeded);
+    advent_io_own_prng io6, io7;
+    s6.start(io6);
+    s7.start(io7);
+    for (int n = 0; n < 50; ++n) {
+        for (const auto & command : commands) {
+            s6.step(command, io6);
+            s7.step(command, io7);
+        }
+    }
+    TEST_EQUAL(io6.output.size() > expected.output.size(), true);
+    TEST_EQUAL(io6.output, io7.output);
+
+    // a game restored from a snapshot must carry on just as the original
+    TEST_EQUAL(sizeof(session_snapshot) < 1024, true);
+    const session_snapshot snapshot = s6.save();
+    session s8(advdat_77_03_31_world());
+    s8.restore(snapshot);
+    TEST_EQUAL(s8.save() == snapshot, true);
+    advent_io_own_prng io8;
+    for (int n = 0; n < 20; ++n) {
+        for (const auto & command : commands) {
+            io6.output.clear();
+            s6.step(command, io6);
+            s8.step(command, io8);
+            TEST_EQUAL(io8.output, io6.output);
+            io8.output.clear();
+        }
+    }
+
+    // as must one saved after the bird is killed, which puts it at location 300
+    session s12(advdat_77_03_31_world(), seeded);
+    s12.start();
+    for (const char * command : {"g", "no", "in", "get lamp", "xyzzy", "light lamp", "west", "west"})
+        s12.step(command);
+    TEST_EQUAL(s12.step("kill bird").find("THE LITTLE BIRD IS NOW DEAD") != std::string::npos, true);
+    session s13(advdat_77_03_31_world());
+    s13.restore(s12.save());
+    TEST_EQUAL(s13.save() == s12.save(), true);
+    for (const char * command : {"east", "west", "look", "get bird"})
+        TEST_EQUAL(s13.step(command), s12.step(command));
+
+    // a snapshot must not be restored into a game with different data
+    auto other = std::make_shared<world>(*advdat_77_03_31_world());
+    other->lline[1][3] = scaffolding::as_a5("ROAM");
+    fingerprint_tables(*other);
+    session s9(other);
+    bool rejected = false;
+    try {
+        s9.restore(snapshot);
+    }
+    catch (const scaffolding::adventure_exception &) {
+        rejected = true;
+    }
+    TEST_EQUAL(rejected, true);
+
+    // step() returns each response as a string
+    session s3(advdat_77_03_31_world());
+    TEST_EQUAL(s3.start().find("PAUSE: INIT DONE\n") == 0, true);
+    TEST_EQUAL(s3.step("g").find("EXECUTION RESUMED\n\nWELCOME TO ADVENTURE!!"), 0);
+    TEST_EQUAL(s3.step("no").find("YOU ARE STANDING AT THE END OF A ROAD"), 0);
+
+    // a game ends, without an exception, when the user types X at a PAUSE
+    session s10(advdat_77_03_31_world());
+    advent_io_test_session io10(commands);
+    TEST_EQUAL(s10.start(io10) == session_status::awaiting_input, true);
+    TEST_EQUAL(s10.step("Z", io10) == session_status::awaiting_input, true);
+    TEST_EQUAL(s10.step("x", io10) == session_status::terminated, true);
+    const auto final_output = io10.output;
+    TEST_EQUAL(s10.step("g", io10) == session_status::terminated, true);
+    TEST_EQUAL(io10.output, final_output);
+    session s11(advdat_77_03_31_world());
+    s11.restore(s10.save());
+    TEST_EQUAL(s11.status() == session_status::terminated, true);
+
+    // sessions share one copy of the world; each holds only its own game state
+    const auto uses = advdat_77_03_31_world().use_count();
+    auto s4 = std::make_unique<session>(advdat_77_03_31_world());
+    TEST_EQUAL(advdat_77_03_31_world().use_count(), uses + 1);
+    s4.reset();
+    TEST_EQUAL(advdat_77_03_31_world().use_count(), uses);
+    TEST_EQUAL(sizeof(session) < sizeof(world) / 20, true);
+    TEST_EQUAL(sizeof(session) < 3 * 1024, true);   // [with 16-bit object and location tables]
+}
+
+DEF_TEST_FUNC(step_many)
+{
+    const shared_world w = advdat_77_03_31_world();
+    const shared_world other = std::make_shared<world>(*w);
+    const std::vector<std::string> commands = {
+        "g", "no", "in", "get lamp", "xyzzy", "light lamp", "pit", "fred"
+    };
+
+    // each game: its tables and seed
+    const std::vector<std::pair<shared_world, uint_least64_t>> games = {
+        {w, 1}, {other, 2}, {w, 3}, {other, 4}, {w, 5}
+    };
+    auto options = [](uint_least64_t seed) {
+        session_options result;
+        result.seed = seed;
+        return result;
+    };
+
+    // the expected output is that of each game stepped on its own
+    std::vector<std::vector<std::string>> expected;
+    for (const auto & [tables, seed] : games) {
+        session s(tables, options(seed));
+        expected.emplace_back();
+        for (const auto & command : commands)
+            expected.back().push_back(s.step(command));
+    }
+
+    // the same games stepped a batch at a time, one command per game per
+    // batch, except that the last game is given its commands two at a time
+    std::vector<std::unique_ptr<session>> sessions;
+    for (const auto & [tables, seed] : games)
+        sessions.push_back(std::make_unique<session>(tables, options(seed)));
+    std::vector<session_reply> replies;
+    for (size_t n = 0; n < commands.size(); ++n) {
+        std::vector<session_command> batch;
+        std::vector<std::pair<size_t, size_t>> want; // (game, command)
+        auto add = [&](size_t g, size_t c) {
+            batch.push_back({sessions[g].get(), commands[c]});
+            want.emplace_back(g, c);
+        };
+        const size_t last = sessions.size() - 1;
+        if (n % 2 == 0)
+            add(last, n);
+        for (size_t g = 0; g < last; ++g)
+            add(g, n);
+        if (n % 2 == 0)
+            add(last, n + 1);
+        step_many(batch, replies);
+        TEST_EQUAL(replies.size(), batch.size());
+        for (size_t r = 0; r < batch.size(); ++r) {
+            TEST_EQUAL(replies[r].output, expected[want[r].first][want[r].second]);
+            TEST_EQUAL(replies[r].status == session_status::awaiting_input, true);
+        }
+    }
+
+    // the game's status is reported once it's over
+    session s(w);
+    const auto over = step_many({{&s, "x"}, {&s, "x"}});
+    TEST_EQUAL(over[0].output.find("PAUSE: INIT DONE") != std::string::npos, true);
+    TEST_EQUAL(over[0].status == session_status::terminated, true);
+    TEST_EQUAL(over[1].output, "");
+
+    // a batch cut short by a step that throws leaves nothing of the last
+    // batch in the replies to the steps not taken
+    std::vector<session_reply> reused = over;
+    reused.resize(4, over[0]);
+    session t(w);
+    bool threw = false;
+    try {
+        step_many({{&t, "g"}, {&t, "no"}, {&t, "back"}, {&t, "in"}}, reused);
+    }
+    catch (const std::exception &) {
+        threw = true;
+    }
+    TEST_EQUAL(threw, true);
+    TEST_EQUAL(reused[1].output.find("END OF A ROAD") != std::string::npos, true);
+    TEST_EQUAL(reused[3].output, "");
+    TEST_EQUAL(reused[3].status == session_status::awaiting_input, true);
+}
+
+
+DEF_TEST_FUNC(adventure_task)
+{
+    class advent_io_async_test : public scaffolding::advent_io_async {
+    public:
+        using advent_io::type;
+        void type(const std::string & msg) override { output += msg; }
+        void type(std::string_view msg) override { output += msg; }
+        void type(int n) override { output += std::to_string(n); }
+        std::string output;
+    };
+
+    const std::vector<std::string> commands = {
+        "g", "no", "in", "get lamp", "xyzzy", "light lamp", "pit", "down"
+    };
+
+    // many games, all waiting for input on this thread
+    session expected(advdat_77_03_31_world());
+    std::string expected_output = expected.start();
+    std::vector<advent_io_async_test> ios(100);
+    std::vector<adventure_task> games;
+    for (auto & io : ios)
+        games.push_back(play(advdat_77_03_31_world(), io));
+    for (const auto & command : commands) {
+        expected_output += expected.step(command);
+        for (auto & io : ios) {
+            TEST_EQUAL(io.waiting(), true);
+            io.supply(command);
+        }
+    }
+    bool all_same = true;
+    for (size_t n = 0; n < ios.size(); ++n)
+        all_same = all_same && ios[n].output == expected_output && !games[n].done();
+    TEST_EQUAL(all_same, true);
+
+    // a game ended by the user is done, without an exception
+    advent_io_async_test io;
+    adventure_task game = play(advdat_77_03_31_world(), io);
+    io.supply("x"); // (terminate at the first PAUSE)
+    TEST_EQUAL(game.done(), true);
+    TEST_EQUAL(io.waiting(), false);
+    bool failed = false;
+    try {
+        game.rethrow_if_failed();
+    }
+    catch (...) {
+        failed = true;
+    }
+    TEST_EQUAL(failed, false);
+}
+
+DEF_BENCH_FUNC(session_snapshot)
+{
+    session s(advdat_77_03_31_world());
+    s.start();
+    s.step("no");
+    s.step("in");
+    session_snapshot snapshot{};
+    BENCHMARK("session::save", 100000, [&] {
+        snapshot = s.save();
+        return snapshot[20];
+    });
+    BENCHMARK("session::restore", 100000, [&] {
+        s.restore(snapshot);
+        return snapshot[21];
+    });
+}
+
+// [Is a cache of rendered room output worth having? The time to respond
+//  to LOOK in the building with three objects there, to walk out and back
+//  in, and to a word that isn't in the vocabulary, which types no room
+//  output at all; and the time to copy the LOOK response, the least a
+//  cache hit could cost.]
+DEF_BENCH_FUNC(room_output)
+{
+    class advent_io_null : public scaffolding::advent_io {
+    public:
+        std::string getline() override { return {}; }
+        void type(const std::string & msg) override { size += msg.size(); }
+        void type(std::string_view msg) override { size += msg.size(); }
+        void type(int) override {}
+
+        size_t size = 0;
+    } io;
+    session s(advdat_77_03_31_world());
+    for (const char * command : {"g", "no", "in", "get lamp"})
+        s.step(command, io);
+    BENCHMARK("step(look)", 100000, [&] {
+        s.step("look", io);
+        return io.size;
+    });
+    int n = 0;
+    BENCHMARK("step(out/in)", 100000, [&] {
+        s.step(n++ % 2 ? "in" : "out", io);
+        return io.size;
+    });
+    BENCHMARK("step(unknown word)", 100000, [&] {
+        s.step("foo", io);
+        return io.size;
+    });
+    const std::string response = s.step("look");
+    std::string output;
+    BENCHMARK("copy the look response", 100000, [&] {
+        output.assign(response);
+        return output.size();
+    });
+}
+
+
+// [Commands for benchmark games: after "g" to resume from INIT DONE, a round
+//  trip from the road to the Hall of the Mountain King and back.]
+const std::vector<std::string> & scripted_tour()
+{
+    static const std::vector<std::string> tour = {
+        "no", "in", "get lamp", "get keys", "get food", "get bottle", "out",
+        "south", "south", "south", "unlock grate", "down", "west", "get cage",
+        "west", "light lamp", "east", "pit", "down", "south", "get silver",
+        "north", "down", "look", "up", "look", "west", "east", "north", "south",
+        "up", "east", "look", "up", "east", "xyzzy", "plugh", "look", "fred"
+    };
+    return tour;
+}
+
+
+// [Headless throughput of the whole game: the time to parse the data file,
+//  to start a game, and to respond to each command, for 1..N games played
+//  at once on N threads.]
+DEF_BENCH_FUNC(adventure)
+{
+    class advent_io_null : public scaffolding::advent_io {
+    public:
+        using advent_io::type;
+        std::string getline() override { return {}; }
+        void type(const std::string &) override {}
+        void type(std::string_view) override {}
+        void type(int) override {}
+    };
+
+    const std::vector<std::string> & tour = scripted_tour();
+    constexpr int rounds = 50;
+
+    const double parse_ms = [] {
+        class advent_io_loader : public scaffolding::advent_io {
+        public:
+            std::string getline() override { return "X"; }
+            void type(const std::string &) override {}
+            void type(int) override {}
+        } io;
+        std::istringstream iss(advdat_77_03_31);
+        const auto start = std::chrono::steady_clock::now();
+        auto w = load_world(iss, io);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }();
+    std::cout << "adventure: parse " << parse_ms << " ms\n";
+    advdat_77_03_31_world(); // (so the shared world is loaded before the timing starts)
+
+    const unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<std::vector<double>> startup_us(threads), command_us(threads);
+        std::vector<std::thread> pool;
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                advent_io_null io;
+                for (int r = 0; r < rounds; ++r) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    session_options options;
+                    options.seed = t * rounds + r + 1;
+                    session s(advdat_77_03_31_world(), options);
+                    s.start(io);
+                    s.step("g", io);
+                    auto t1 = std::chrono::steady_clock::now();
+                    startup_us[t].push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+                    for (const auto & command : tour) {
+                        t0 = t1;
+                        s.step(command, io);
+                        t1 = std::chrono::steady_clock::now();
+                        command_us[t].push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+                    }
+                }
+            });
+        }
+        for (auto & thread : pool)
+            thread.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<double> startups, commands;
+        for (unsigned t = 0; t < threads; ++t) {
+            startups.insert(startups.end(), startup_us[t].begin(), startup_us[t].end());
+            commands.insert(commands.end(), command_us[t].begin(), command_us[t].end());
+        }
+        std::cout
+            << "adventure: " << threads << " sessions: "
+            << commands.size() / elapsed.count() << " commands/s, startup p50 "
+            << micro_test_library::percentile(startups, 50) << " us, command p50 "
+            << micro_test_library::percentile(commands, 50) << " us p99 "
+            << micro_test_library::percentile(commands, 99) << " us\n";
+    }
+}
+
+
+// [The time to step 1000 games once each, in one batch with step_many(),
+//  and one at a time with session::step().]
+DEF_BENCH_FUNC(step_many)
+{
+    const shared_world w = advdat_77_03_31_world();
+    const auto & tour = scripted_tour();
+    constexpr int games = 1000;
+    auto new_games = [&] {
+        std::vector<std::unique_ptr<session>> sessions;
+        for (int g = 0; g < games; ++g) {
+            sessions.push_back(std::make_unique<session>(w));
+            sessions.back()->step("g");
+        }
+        return sessions;
+    };
+
+    auto batched = new_games();
+    std::vector<session_command> batch;
+    for (const auto & game : batched)
+        batch.push_back({game.get(), {}});
+    std::vector<session_reply> replies;
+    size_t n = 0;
+    BENCHMARK("step_many (1000 games)", 100, [&] {
+        const auto & command = tour[n++ % tour.size()];
+        for (auto & command_line : batch)
+            command_line.input_line = command;
+        step_many(batch, replies);
+        return replies[0].output.size();
+    });
+
+    auto single = new_games();
+    n = 0;
+    BENCHMARK("session::step (1000 games)", 100, [&] {
+        const auto & command = tour[n++ % tour.size()];
+        size_t size = 0;
+        for (const auto & game : single)
+            size += game->step(command).size();
+        return size;
+    });
+}
+
+
+// [Play the given number of games of the scripted tour at once with a
+//  session_scheduler, each game posting its next command from the output
+//  handler. Return the number of steps taken and the time they took.]
+struct stress_result {
+    size_t steps;
+    double seconds;
+};
+
+stress_result stress(unsigned games, unsigned workers)
+{
+    const std::vector<std::string> & tour = scripted_tour();
+    std::vector<size_t> next(games, 0);           // [index of each game's next command]
+    std::atomic<size_t> steps{0};
+    session_scheduler * scheduler = nullptr;
+    session_scheduler s(advdat_77_03_31_world(),
+        [&](session_scheduler::session_id id, std::string_view, session_status status) {
+            ++steps;
+            if (status == session_status::terminated || next[id] > tour.size())
+                return;
+            scheduler->post(id, next[id] == 0 ? "g" : tour[next[id] - 1]);
+            ++next[id];
+        }, workers);
+    scheduler = &s;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned n = 0; n < games; ++n) {
+        session_options options;
+        options.seed = n + 1;
+        s.open(options);
+    }
+    s.wait_idle();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {steps, elapsed.count()};
+}
+
+DEF_TEST_FUNC(explore)
+{
+    const shared_world w = advdat_77_03_31_world();
+    const std::vector<std::string> words = {"no", "yes", "east", "west", "in", "out", "xyzzy", "plugh", "get", "lamp"};
+
+    explore_options options;
+    options.depth = 4;
+    options.threads = 1;
+    const explore_report alone = explore(w, words, options);
+    options.threads = 3;
+    const explore_report shared = explore(w, words, options);
+
+    // the search must find the same states however many threads share it
+    TEST_EQUAL(shared.states, alone.states);
+    TEST_EQUAL(shared.steps, alone.steps);
+    TEST_EQUAL(shared.duplicates, alone.duplicates);
+    TEST_EQUAL(shared.locations == alone.locations, true);
+    TEST_EQUAL(shared.depth, 4);
+    TEST_EQUAL(alone.steps, alone.states - 1 + alone.duplicates + alone.terminated + alone.errors);
+    TEST_EQUAL(alone.errors, 0u);
+
+    // [road, building, hill, debris room via xyzzy, Y2 via plugh]
+    for (const int loc : {1, 2, 3, 11, 33})
+        TEST_EQUAL(alone.locations[loc], true);
+    TEST_EQUAL(alone.resume_points[2] && alone.resume_points[6], true);
+
+    // [the labels passed: the same however many threads share the search, and
+    //  all of them in game_labels(); e.g. not 83, where the dwarves win]
+    TEST_EQUAL(shared.labels == alone.labels, true);
+    TEST_EQUAL((alone.labels & ~game_labels()).none(), true);
+    for (const int label : {1100, 2, 74, 71, 8, 2020, 2023, 9000})
+        TEST_EQUAL(alone.labels[label], true);
+    TEST_EQUAL(alone.labels[83], false);
+
+    // games that differ only in the last word typed are in the same state
+    session s1(w), s2(w);
+    for (session * s : {&s1, &s2}) {
+        s->start();
+        s->step("g");
+        s->step("no");
+    }
+    s1.step("plover");
+    s2.step("frobozz");
+    TEST_EQUAL(s1.save() == s2.save(), false);
+    TEST_EQUAL(s1.state_hash(), s2.state_hash());
+
+    const auto vocabulary = vocabulary_words(*w);
+    TEST_EQUAL(std::find(vocabulary.begin(), vocabulary.end(), "XYZZY") != vocabulary.end(), true);
+}
+
+
+DEF_TEST_FUNC(instrumentation)
+{
+    using instrumentation = scaffolding::instrumentation;
+    const std::vector<std::string> commands = {"g", "no", "east", "west", "in", "xyzzy", "get lamp"};
+
+    std::string plain, output;
+    session s1(advdat_77_03_31_world());
+    plain = s1.start();
+    for (const auto & command : commands)
+        plain += s1.step(command);
+
+    instrumentation counters;
+    session s2(advdat_77_03_31_world());
+    scaffolding::advent_io_string out(output);
+    scaffolding::advent_io_instrumented io(out, counters);
+    s2.start(io);
+    for (const auto & command : commands)
+        s2.step(command, io);
+
+    // instrumentation doesn't change the game
+    TEST_EQUAL(output, plain);
+    TEST_EQUAL(counters.phase_time[instrumentation::vocabulary].count, commands.size() - 1);
+    TEST_EQUAL(counters.phase_time[instrumentation::travel].count, 4u);        // [east, west, in, xyzzy]
+    TEST_EQUAL(counters.phase_time[instrumentation::description].count, 5u);   // [road, building, road, building, debris room]
+    TEST_EQUAL(counters.phase_time[instrumentation::dwarves].count, 5u);
+    TEST_EQUAL(counters.phase_time[instrumentation::speak].count > 0, true);
+    TEST_EQUAL(counters.ran_calls, 0u);    // [no dwarves yet, and not at Y2]
+    s2.step("plover", io);                 // [not a word: two calls of ran() choose the reply]
+    TEST_EQUAL(counters.ran_calls, 2u);
+    TEST_EQUAL(counters.bytes_typed, output.size());
+
+    instrumentation total;
+    total += counters;
+    total += counters;
+    TEST_EQUAL(total.ran_calls, 2 * counters.ran_calls);
+    const std::string text = total.prometheus_text();
+    TEST_EQUAL(text.find("advent_phase_seconds_count{phase=\"vocabulary\"} 14\n") != std::string::npos, true);
+    TEST_EQUAL(text.find("advent_phase_seconds_bucket{phase=\"travel\",le=\"+Inf\"} 8\n") != std::string::npos, true);
+    TEST_EQUAL(text.find("advent_typed_bytes_total " + std::to_string(2 * output.size()) + "\n") != std::string::npos, true);
+}
+
+
+DEF_TEST_FUNC(replay)
+{
+    const shared_world w = advdat_77_03_31_world();
+
+    // record some games, given their input by step() and by getline()
+    std::string logs;
+    for (uint_least64_t seed = 1; seed <= 3; ++seed) {
+        std::string output;
+        scaffolding::advent_io_string out(output);
+        advent_io_recorder io(out, logs, *w, seed);
+        session_options options;
+        options.seed = seed;
+        session s(w, options);
+        s.start(io);
+        for (const auto & command : {"g", "no", "in", "xyzzy", "plugh", "out", "west", "x"}) {
+            io.input(command);
+            s.step(command, io);
+        }
+    }
+    {
+        struct done {};
+        class advent_io_script : public scaffolding::advent_io_string {
+        public:
+            using advent_io_string::advent_io_string;
+            std::string getline() override
+            {
+                const char * script[] = {"g", "no", "east", "get water"};
+                if (next_ == std::size(script))
+                    throw done();
+                return script[next_++];
+            }
+        private:
+            size_t next_ = 0;
+        };
+        std::string output;
+        advent_io_script script(output);
+        try {
+            advent_io_recorder io(script, logs, *w, 7);
+            session_options options;
+            options.seed = 7;
+            adventure(w, io, options);
+        }
+        catch (const done &) {}
+    }
+
+    std::string_view rest = logs;
+    const std::string_view first = replay_log::next(rest);
+    TEST_EQUAL(replay(w, first), "");
+    const auto summary = replay_all(w, logs, 2);
+    TEST_EQUAL(summary.games, 4u);
+    TEST_EQUAL(summary.failures, 0u);
+    TEST_EQUAL(summary.first_failure, "");
+
+    // a game that goes differently is caught at the step where it differs
+    std::string altered(first);
+    altered[5] ^= 1;                                // (the table fingerprint)
+    TEST_EQUAL(replay(w, altered), "recorded with different tables");
+    altered = first;
+    altered.replace(altered.rfind("plugh"), 5, "PLUGH");
+    TEST_EQUAL(replay(w, altered), "");             // (the same as far as the game is concerned)
+    altered.replace(altered.rfind("PLUGH"), 5, "XYZZY");
+    TEST_EQUAL(replay(w, altered), "step 5: location differs");
+    TEST_EQUAL(replay(w, first.substr(0, first.size() - 1)), "step 8: replay log: truncated or corrupt");
+    TEST_EQUAL(replay(w, "ADVS"), "not a replay log");
+    TEST_EQUAL(replay(w, "ADVL"), "step 0: replay log: truncated or corrupt");
+
+    // a game is replayed with whichever of the given tables it was played with
+    const shared_world old = advdat_77_03_11_world();
+    std::string old_log;
+    {
+        std::string output;
+        scaffolding::advent_io_string out(output);
+        advent_io_recorder io(out, old_log, *old, 1);
+        session s(old);
+        s.start(io);
+        for (const auto & command : {"g", "no", "in", "x"}) {
+            io.input(command);
+            s.step(command, io);
+        }
+    }
+    TEST_EQUAL(replay(w, old_log), "recorded with different tables");
+    TEST_EQUAL(replay({w, old}, old_log), "");
+    TEST_EQUAL(replay_all({w, old}, logs + old_log, 1).failures, 0u);
+
+    // a game in which Crowther's code fails is reported, not fatal: BACK as
+    // the first move goes to location 9999
+    std::string fails;
+    {
+        std::string output;
+        scaffolding::advent_io_string out(output);
+        advent_io_recorder io(out, fails, *w, 1);
+        session s(w);
+        s.start(io);
+        try {
+            for (const auto & command : {"g", "no", "back"}) {
+                io.input(command);
+                s.step(command, io);
+            }
+        }
+        catch (const std::out_of_range &) {}
+    }
+    TEST_EQUAL(replay(w, fails).substr(0, 8), "step 3: ");
+    TEST_EQUAL(replay_all(w, fails, 1).failures, 1u);
+
+    const auto broken = replay_all(w, std::string(first) + altered + std::string(first.substr(0, 30)), 1);
+    TEST_EQUAL(broken.games, 2u);
+    TEST_EQUAL(broken.failures, 2u);
+    TEST_EQUAL(broken.first_failure.substr(0, 7), "game 2:");   // [the truncated log is found first]
+}
+
+
+DEF_TEST_FUNC(session_scheduler)
+{
+    constexpr unsigned games = 50;
+    const std::vector<std::string> commands = {"g", "no", "in", "get lamp", "xyzzy", "plugh", "fred"};
+
+    // the output of each game played on the scheduler must be as if played alone
+    std::vector<std::string> expected(games);
+    for (unsigned n = 0; n < games; ++n) {
+        session_options options;
+        options.seed = n + 1;
+        session s(advdat_77_03_31_world(), options);
+        expected[n] = s.start();
+        for (const auto & command : commands)
+            expected[n] += s.step(command);
+    }
+
+    std::vector<std::string> output(games);
+    {
+        session_scheduler scheduler(advdat_77_03_31_world(),
+            [&](session_scheduler::session_id id, std::string_view text, session_status) {
+                output.at(id) += text;
+            }, 4);
+        for (unsigned n = 0; n < games; ++n) {
+            session_options options;
+            options.seed = n + 1;
+            TEST_EQUAL(scheduler.open(options), n);
+        }
+        for (const auto & command : commands) {
+            for (unsigned n = 0; n < games; ++n)
+                scheduler.post(n, command);
+        }
+        scheduler.wait_idle();
+    }
+    TEST_EQUAL(output == expected, true);
+
+    // a game evicted between steps carries on as if it never was; the id of
+    // a closed game is reused
+    output.assign(3, {});
+    {
+        session_scheduler scheduler(advdat_77_03_31_world(),
+            [&](session_scheduler::session_id id, std::string_view text, session_status) {
+                output.at(id) += text;
+            }, 2);
+        for (unsigned n = 0; n < 3; ++n) {
+            session_options options;
+            options.seed = n + 1;
+            scheduler.open(options);
+        }
+        for (const auto & command : commands) {
+            scheduler.wait_idle();
+            TEST_EQUAL(scheduler.evict(0), true);
+            TEST_EQUAL(scheduler.evict(0), false);
+            for (unsigned n = 0; n < 3; ++n)
+                scheduler.post(n, command);
+        }
+        scheduler.wait_idle();
+        scheduler.close(2);
+        TEST_EQUAL(scheduler.evict(2), false);
+        scheduler.post(2, "fred"); // (ignored)
+        TEST_EQUAL(scheduler.open(), 2U);
+        scheduler.wait_idle();
+    }
+    TEST_EQUAL(output[0], expected[0]);
+    TEST_EQUAL(output[1], expected[1]);
+    TEST_EQUAL(output[2].starts_with(expected[2]), true);
+
+    // a game whose step throws is reported as failed and takes no more
+    // input; the worker and the other games carry on
+    std::vector<session_status> status(2, session_status::awaiting_input);
+    output.assign(2, {});
+    {
+        session_scheduler scheduler(advdat_77_03_31_world(),
+            [&](session_scheduler::session_id id, std::string_view text, session_status st) {
+                output.at(id) += text;
+                status.at(id) = st;
+            }, 1);
+        scheduler.open();
+        scheduler.open();
+        for (const char * command : {"g", "no", "back", "in"}) {
+            for (unsigned n = 0; n < 2; ++n)
+                scheduler.post(n, n == 0 || std::string(command) != "back" ? command : "out");
+        }
+        scheduler.wait_idle();
+        TEST_EQUAL(scheduler.evict(0), false);
+    }
+    TEST_EQUAL(status[0] == session_status::failed, true);
+    TEST_EQUAL(output[0].find("INSIDE A BUILDING"), std::string::npos);
+    TEST_EQUAL(status[1] == session_status::awaiting_input, true);
+    TEST_EQUAL(output[1].find("INSIDE A BUILDING") != std::string::npos, true);
+
+    // every step of every game must be taken, whether the games post their own input
+    TEST_EQUAL(stress(20, 3).steps, 20 * (scripted_tour().size() + 2));
+}
+
+
+#if ADVENT_HAVE_EPOLL
+DEF_TEST_FUNC(session_server)
+{
+    using namespace std::chrono_literals;
+    server_options options;
+    options.workers = 2;
+    options.evict_after = 0ms; // (evict every game as soon as it's idle)
+    options.max_pending = 2;
+    session_server server(advdat_77_03_31_world(), options);
+    std::thread serving([&] { server.run(); });
+
+    // a client connection; read() returns what arrives up to the given text
+    class client {
+    public:
+        explicit client(uint_least16_t port)
+        {
+            fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            const timeval timeout{5, 0};
+            ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port);
+            connected = ::connect(fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0;
+        }
+        ~client() { ::close(fd_); }
+
+        void send(const std::string & text) { ::send(fd_, text.data(), text.size(), MSG_NOSIGNAL); }
+        void shutdown() { ::shutdown(fd_, SHUT_WR); }
+
+        std::string read(const std::string & until, int times = 1)
+        {
+            auto count = [&] {
+                int n = 0;
+                for (size_t at = received_.find(until); at != std::string::npos; at = received_.find(until, at + 1))
+                    ++n;
+                return n;
+            };
+            char buf[4096];
+            while (count() < times) {
+                const ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+                if (n <= 0) {
+                    closed = n == 0;
+                    break;
+                }
+                received_.append(buf, static_cast<size_t>(n));
+            }
+            std::string result;
+            result.swap(received_);
+            return result;
+        }
+
+        bool connected = false, closed = false;
+
+    private:
+        int fd_;
+        std::string received_;
+    };
+
+    // a game is played over the connection, line by line, and carries on
+    // as before after it has been evicted
+    client player(server.port());
+    TEST_EQUAL(player.connected, true);
+    TEST_EQUAL(player.read("TO TERMINATE").find("PAUSE: INIT DONE") != std::string::npos, true);
+    player.send("g\r\n");
+    TEST_EQUAL(player.read("INSTRUCTIONS?").find("WELCOME TO ADVENTURE") != std::string::npos, true);
+    player.send("no\n");
+    TEST_EQUAL(player.read("GULLY.").find("END OF A ROAD") != std::string::npos, true);
+    std::this_thread::sleep_for(50ms);
+    player.send("\xff\xfb\x01in\n"); // (a telnet command first)
+    TEST_EQUAL(player.read("SPRING.").find("INSIDE A BUILDING") != std::string::npos, true);
+
+    // lines sent faster than they are played are all played, in order
+    std::string lines;
+    for (int n = 0; n < 30; ++n)
+        lines += n % 2 ? "in\n" : "out\n";
+    player.send(lines);
+    const std::string replies = player.read("BOTTLE OF WATER HERE.", 15);
+    TEST_EQUAL(player.closed, false);
+    TEST_EQUAL(replies.rfind("BOTTLE OF WATER HERE.") > replies.rfind("END OF"), true);
+
+    // the connection is closed when the game ends
+    client quitter(server.port());
+    quitter.read("TO TERMINATE");
+    quitter.send("x\n");
+    quitter.read("(never sent)");
+    TEST_EQUAL(quitter.closed, true);
+
+    // a client that shuts down its side is sent the replies to the lines it
+    // sent before, then the connection is closed
+    client leaver(server.port());
+    leaver.send("g\nno\nin\n");
+    leaver.shutdown();
+    const std::string last = leaver.read("(never sent)");
+    TEST_EQUAL(leaver.closed, true);
+    TEST_EQUAL(last.find("INSIDE A BUILDING") != std::string::npos, true);
+
+    // as is the connection of a game whose step throws, and no other
+    client failing(server.port());
+    failing.read("TO TERMINATE");
+    failing.send("g\nno\nback\n");
+    failing.read("(never sent)");
+    TEST_EQUAL(failing.closed, true);
+    client next(server.port());
+    TEST_EQUAL(next.read("TO TERMINATE").find("PAUSE: INIT DONE") != std::string::npos, true);
+    next.send("g\nno\n");
+    TEST_EQUAL(next.read("GULLY.").find("END OF A ROAD") != std::string::npos, true);
+    player.send("out\n");
+    TEST_EQUAL(player.read("AGAIN.").find("END OF ROAD") != std::string::npos, true);
+
+    server.stop();
+    serving.join();
+}
+#endif
+
 } //namespace Crowther
 
 
 
 
 
-int main()
+int main(int argc, char * argv[])
 {
+    // "advent --test" runs the self-tests, reporting the time each took;
+    // "advent --no-tests ..." starts without running the self-tests, as do
+    // all builds with ADVENT_NO_STARTUP_TESTS defined.
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 1 && args[0] == "--test") {
+        RUN_TESTS_TIMED();
+        return micro_test_library::fault_count ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    bool startup_tests = true;
+#ifdef ADVENT_NO_STARTUP_TESTS
+    startup_tests = false;
+#endif
+    if (!args.empty() && args[0] == "--no-tests") {
+        startup_tests = false;
+        args.erase(args.begin());
+    }
+
     std::cout
         << "-----------------------------------------------------------------\n"
         << "     Will Crowther's original 1976 \"Colossal Cave Adventure\"\n"
@@ -2724,7 +8873,8 @@ int main()
         << "To quit hit Ctrl-C\n\n";
 
     try {
-        RUN_TESTS();
+        if (startup_tests)
+            RUN_TESTS();
 
 
         class advent_io_console : public scaffolding::advent_io {
@@ -2740,13 +8890,204 @@ int main()
             }
 
             void type(const std::string & msg) override { std::cout << msg; }
+            void type(std::string_view msg) override { std::cout << msg; }
             void type(int n) override { std::cout << n; }
         };
 
 
-        std::istringstream iss(Crowther::advdat_77_03_31);
-        advent_io_console io;
-        Crowther::adventure<std::istringstream>(iss, io);
+        // "advent --write-image FILE" writes the built-in tables to a world image;
+        // "advent --image FILE" plays the game using the tables in a world image;
+        // "advent --seed N" plays the game with the given random number seed;
+        // "advent --bench [NAME]" runs the benchmarks, or just the one named;
+        // "advent --stress N [WORKERS]" plays N thousand scripted games at once;
+        // "advent --data FILE" plays the game using the tables in an Adventure data file;
+        // "advent --revision R" plays the game using the compiled-in data file revision R;
+        // "advent --share NAME" places the tables in shared memory, for "--attach NAME";
+        // "advent --attach NAME" plays the game using the tables placed in shared memory;
+        // "advent --unshare NAME" removes the tables placed in shared memory;
+        // "advent --explore DEPTH [THREADS]" types every word in every state to the given depth;
+        // "advent --map FROM TO" shows a shortest route from one location to another;
+        // "advent --serve PORT [WORKERS]" plays a game for each TCP connection to PORT;
+        // "advent --metrics FILE" writes the counts and times of the game's phases to FILE;
+        // "advent --record FILE" appends a replay log of the game to FILE;
+        // "advent --replay FILE [THREADS]" replays and checks every game logged in FILE,
+        //      each with the compiled-in revision it was recorded with, or with the
+        //      tables given by any --data, --image, --revision or --attach after it.
+        advent_io_console console;
+
+        // (the tables an --image, --data, --revision or --attach option names, or null
+        //  if the option isn't one of those)
+        auto tables_option = [&](const std::string & option, const std::string & value) {
+            Crowther::shared_world w;
+            if (option == "--image") {
+                auto image = std::make_shared<Crowther::world>();
+                std::ifstream is(value, std::ios::binary);
+                Crowther::read_image(is, *image);
+                w = image;
+            }
+            else if (option == "--data")
+                w = Crowther::load_world_file(value, console);
+            else if (option == "--revision") {
+                w = Crowther::compiled_world(value);
+                if (!w)
+                    throw scaffolding::adventure_exception("no such data file revision");
+            }
+            else if (option == "--attach")
+                w = Crowther::attach_shared_world(value);
+            return w;
+        };
+        if (args.size() == 1 && args[0] == "--bench") {
+            RUN_BENCHMARKS();
+            return EXIT_SUCCESS;
+        }
+        if (args.size() == 2 && args[0] == "--bench")
+            return RUN_BENCHMARK(args[1]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        if ((args.size() == 2 || args.size() == 3) && args[0] == "--stress") {
+            const unsigned games = static_cast<unsigned>(std::stoul(args[1]) * 1000);
+            const unsigned workers = args.size() == 3 ? static_cast<unsigned>(std::stoul(args[2])) : 0;
+            const auto result = Crowther::stress(games, workers);
+            std::cout
+                << "stress: " << games << " games: " << result.steps << " steps in "
+                << result.seconds << " s, " << result.steps / result.seconds << " steps/s\n";
+            return EXIT_SUCCESS;
+        }
+        if (args.size() >= 2 && args[0] == "--replay") {
+            std::ifstream is(args[1], std::ios::binary);
+            const std::string logs{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+            size_t next = 2;
+            unsigned threads = 0;
+            if (next < args.size() && !args[next].starts_with("--"))
+                threads = static_cast<unsigned>(std::stoul(args[next++]));
+            std::vector<Crowther::shared_world> worlds;
+            for (; next + 1 < args.size(); next += 2) {
+                if (auto w = tables_option(args[next], args[next + 1]))
+                    worlds.push_back(std::move(w));
+            }
+            for (const auto & data : Crowther::compiled_data_files)
+                worlds.push_back(data.tables());
+            const auto summary = Crowther::replay_all(worlds, logs, threads);
+            std::cout
+                << "replay: " << summary.games << " games in " << summary.seconds << " s, "
+                << summary.games / summary.seconds << " games/s, "
+                << summary.failures << " failures\n";
+            if (summary.failures)
+                std::cout << summary.first_failure << '\n';
+            return summary.failures ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+        if ((args.size() == 2 || args.size() == 3) && args[0] == "--explore") {
+            const Crowther::shared_world w = Crowther::advdat_77_03_31_world();
+            Crowther::explore_options options;
+            options.depth = std::stoi(args[1]);
+            options.threads = args.size() == 3 ? static_cast<unsigned>(std::stoul(args[2])) : 0;
+            const auto report = Crowther::explore(w, Crowther::vocabulary_words(*w), options);
+            const auto locations = std::count(report.locations.begin(), report.locations.end(), true);
+            const auto resume_points = std::count(report.resume_points.begin() + 1, report.resume_points.end(), true);
+            const auto labels = Crowther::game_labels();
+            const auto labels_reached = (report.labels & labels).count();
+            std::cout
+                << "explore: depth " << report.depth << ": " << report.states << " states, "
+                << report.steps << " steps (" << report.duplicates << " to states already seen, "
+                << report.terminated << " ending the game) in " << report.seconds << " s\n"
+                << "explore: " << locations << " locations, " << labels_reached << " of "
+                << labels.count() << " labels and " << resume_points << " of 14 ACCEPTs and PAUSEs reached\n";
+            if (labels_reached < labels.count()) {
+                std::cout << "explore: labels not reached:";
+                for (size_t n = 0; n < labels.size(); ++n)
+                    if (labels[n] && !report.labels[n])
+                        std::cout << ' ' << n;
+                std::cout << '\n';
+            }
+            if (report.errors)
+                std::cout << "explore: " << report.errors << " steps failed, e.g. " << report.first_error << '\n';
+            return EXIT_SUCCESS;
+        }
+        if (args.size() == 3 && args[0] == "--map") {
+            const Crowther::world & w = *Crowther::advdat_77_03_31_world();
+            const Crowther::map_graph g = Crowther::build_map_graph(w);
+            const Crowther::map_paths paths(g);
+            const int from = std::stoi(args[1]), to = std::stoi(args[2]);
+            if (!paths.reachable(from, to)) {
+                std::cout << to << " cannot be reached from " << from << '\n';
+                return EXIT_FAILURE;
+            }
+            std::cout << paths.distance(from, to) << " moves:";
+            for (const auto & step : paths.path(from, to)) {
+                std::cout << ' ' << Crowther::motion_word(w, step.motion);
+                if (step.special)
+                    std::cout << "(" << step.special << ")";
+                std::cout << ' ' << step.to;
+            }
+            std::cout << '\n';
+            return EXIT_SUCCESS;
+        }
+#if ADVENT_HAVE_EPOLL
+        if ((args.size() == 2 || args.size() == 3) && args[0] == "--serve") {
+            Crowther::server_options options;
+            options.port = static_cast<uint_least16_t>(std::stoul(args[1]));
+            options.workers = args.size() == 3 ? static_cast<unsigned>(std::stoul(args[2])) : 0;
+            Crowther::session_server server(Crowther::advdat_77_03_31_world(), options);
+            std::cout << "serving on port " << server.port() << std::endl;
+            server.run();
+            return EXIT_SUCCESS;
+        }
+#endif
+        if (args.size() == 2 && args[0] == "--unshare") {
+            Crowther::unlink_shared_world(args[1]);
+            return EXIT_SUCCESS;
+        }
+        if (args.size() == 2 && args[0] == "--write-image") {
+            std::ofstream os(args[1], std::ios::binary);
+            Crowther::write_image(os, *Crowther::advdat_77_03_31_world());
+            return EXIT_SUCCESS;
+        }
+
+        Crowther::shared_world w; // (the built-in tables unless others are given)
+        Crowther::session_options options;
+        options.seed = std::random_device{}();
+        std::string record_file, metrics_file, share_name;
+        for (size_t i = 0; i + 1 < args.size(); i += 2) {
+            if (auto tables = tables_option(args[i], args[i + 1]))
+                w = std::move(tables);
+            else if (args[i] == "--share")
+                share_name = args[i + 1];
+            else if (args[i] == "--seed")
+                options.seed = std::stoull(args[i + 1]);
+            else if (args[i] == "--record")
+                record_file = args[i + 1];
+            else if (args[i] == "--metrics")
+                metrics_file = args[i + 1];
+        }
+        if (!w)
+            w = Crowther::advdat_77_03_31_world();
+        if (!share_name.empty()) {
+            Crowther::publish_shared_world(share_name, *w);
+            return EXIT_SUCCESS;
+        }
+
+        // (the game is played through a buffer so that each response is one write)
+        scaffolding::instrumentation counters;
+        scaffolding::advent_io_instrumented instrumented(console, counters);
+        scaffolding::advent_io_buffered io(metrics_file.empty()
+            ? static_cast<scaffolding::advent_io &>(console) : instrumented);
+        if (record_file.empty())
+            Crowther::adventure(w, io, options);
+        else {
+            // (the log is written when the game ends at a PAUSE; not if it's ended with Ctrl-C)
+            std::string log;
+            {
+                Crowther::advent_io_recorder recorder(io, log, *w, options.seed);
+                Crowther::adventure(w, recorder, options);
+            }
+            std::ofstream os(record_file, std::ios::binary | std::ios::app);
+            os << log;
+        }
+        io.flush();
+        if (!metrics_file.empty()) {
+            std::ofstream os(metrics_file);
+            os << counters.prometheus_text();
+        }
+        std::cout << "EXECUTION TERMINATED.\n";
+        return EXIT_FAILURE;
     }
     catch (const scaffolding::adventure_pause_exception &) {
         std::cout << "EXECUTION TERMINATED.\n";